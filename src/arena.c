@@ -0,0 +1,158 @@
+/*******************************************************************************
+ * File: arena.c
+ *
+ * Purpose:
+ *		A slab allocator that carves many CPU states and their address spaces
+ *		out of large preallocated blocks.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#include "arena.h"
+
+#include "memory.h"
+
+#include <stdlib.h>
+
+typedef struct ArenaBlock {
+	uint8_t *base;
+	CPUState *states;
+	uint8_t *memory;
+} ArenaBlock;
+
+struct CPUArena {
+	size_t slots_per_block;
+	size_t block_bytes;
+	size_t states_bytes;
+	int huge;
+	int numa_node;
+	ArenaBlock *blocks;
+	size_t block_count;
+	size_t fresh; // Slots in the last block that have never been handed out
+	CPUState **free_slots;
+	size_t free_count;
+	size_t free_capacity;
+	size_t live;
+};
+
+// Creates an empty arena
+CPUArena *arena_create(size_t slots_per_block, int huge, int numa_node)
+{
+	CPUArena *arena;
+	if (slots_per_block == 0)
+		return NULL;
+	arena = calloc(1, sizeof(CPUArena));
+	if (!arena)
+		return NULL;
+	arena->slots_per_block = slots_per_block;
+	// States are packed at the front of the block; pad them out to a page so
+	// every address space behind them starts page-aligned.
+	arena->states_bytes = (slots_per_block * sizeof(CPUState) + 4095) & ~(size_t)4095;
+	arena->block_bytes = arena->states_bytes + slots_per_block * MEMORY_SIZE;
+	arena->huge = huge;
+	arena->numa_node = numa_node;
+	return arena;
+}
+
+// Maps another block of slots
+static int arena_grow(CPUArena *arena)
+{
+	ArenaBlock *blocks = realloc(arena->blocks, (arena->block_count + 1) * sizeof(ArenaBlock));
+	ArenaBlock *block;
+	if (!blocks)
+		return 0;
+	arena->blocks = blocks;
+	block = &arena->blocks[arena->block_count];
+	block->base = memory_map_block(arena->block_bytes, arena->huge);
+	if (!block->base)
+		return 0;
+	memory_bind_node(block->base, arena->block_bytes, arena->huge, arena->numa_node);
+	block->states = (CPUState *)block->base;
+	block->memory = block->base + arena->states_bytes;
+	arena->block_count++;
+	arena->fresh = arena->slots_per_block;
+	return 1;
+}
+
+// Hands out a CPU state
+CPUState *arena_acquire(CPUArena *arena)
+{
+	CPUState *state;
+	if (arena->free_count > 0)
+	{
+		// Recycled slots are most likely still in cache
+		state = arena->free_slots[--arena->free_count];
+		ResetCPUState(state);
+	}
+	else
+	{
+		ArenaBlock *block;
+		size_t slot;
+		if (arena->fresh == 0 && !arena_grow(arena))
+			return NULL;
+		block = &arena->blocks[arena->block_count - 1];
+		slot = arena->slots_per_block - arena->fresh--;
+		// Freshly mapped pages are already zero
+		state = &block->states[slot];
+		state->memory = block->memory + slot * MEMORY_SIZE;
+		state->layout = arena->huge ? CPU_LAYOUT_ARENA_HUGE : CPU_LAYOUT_ARENA;
+		PowerOnCPUState(state);
+	}
+	arena->live++;
+	return state;
+}
+
+// Returns a CPU state to the arena
+void arena_release(CPUArena *arena, CPUState *state)
+{
+	if (!state)
+		return;
+	if (arena->free_count == arena->free_capacity)
+	{
+		size_t capacity = arena->free_capacity ? arena->free_capacity * 2 : arena->slots_per_block;
+		CPUState **slots = realloc(arena->free_slots, capacity * sizeof(CPUState *));
+		if (!slots)
+			return; // The slot leaks until the arena is destroyed
+		arena->free_slots = slots;
+		arena->free_capacity = capacity;
+	}
+	arena->free_slots[arena->free_count++] = state;
+	arena->live--;
+}
+
+// Number of slots currently handed out
+size_t arena_live(const CPUArena *arena)
+{
+	return arena->live;
+}
+
+// Unmaps every block
+void arena_destroy(CPUArena *arena)
+{
+	if (!arena)
+		return;
+	for (size_t i = 0; i < arena->block_count; ++i)
+		memory_unmap_block(arena->blocks[i].base, arena->block_bytes, arena->huge);
+	free(arena->blocks);
+	free(arena->free_slots);
+	free(arena);
+}
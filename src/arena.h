@@ -0,0 +1,70 @@
+/*******************************************************************************
+ * File: arena.h
+ *
+ * Purpose:
+ *		Specification for a slab allocator that carves many CPU states and their
+ *		address spaces out of large preallocated blocks.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "cpu.h"
+
+#include <stddef.h>
+
+typedef struct CPUArena CPUArena;
+
+/**
+ * Creates an empty arena.
+ *
+ * Slots are mapped slots_per_block at a time, each block holding a dense
+ * array of CPU states followed by one page-aligned 64 KB address space per
+ * slot. When huge is non-zero blocks are backed by huge pages where available;
+ * when numa_node is zero or greater their pages are placed on that node.
+ *
+ * An arena is not thread safe; give each thread its own.
+ */
+CPUArena *arena_create(size_t slots_per_block, int huge, int numa_node);
+
+/**
+ * Hands out a CPU state in its power-on state, or NULL if no more memory can
+ * be mapped. Released slots are reused before new ones are touched.
+ */
+CPUState *arena_acquire(CPUArena *arena);
+
+/**
+ * Returns a CPU state to the arena. Its memory stays mapped and is cleared
+ * when the slot is next acquired.
+ */
+void arena_release(CPUArena *arena, CPUState *state);
+
+/**
+ * Number of slots currently handed out.
+ */
+size_t arena_live(const CPUArena *arena);
+
+/**
+ * Unmaps every block. Any states still acquired become invalid.
+ */
+void arena_destroy(CPUArena *arena);
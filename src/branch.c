@@ -61,7 +61,7 @@ void call(CPUState *state, unsigned char *opcode)
 	uint16_t ret = state->pc + 2;
 	uint8_t hi = (ret & 0xff);
 	uint8_t lo = (ret >> 8) & 0xff;
-	push(&hi, &lo, &state->sp, state->memory);
+	push(&hi, &lo, state);
 
 	// Jump to the desired location
 	jmp(state, opcode);
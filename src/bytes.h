@@ -0,0 +1,80 @@
+/*******************************************************************************
+ * File: bytes.h
+ *
+ * Purpose:
+ *		Helpers for reading and writing little-endian values in byte buffers.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+static inline void put_le16(uint8_t *out, uint16_t value)
+{
+	out[0] = (uint8_t)value;
+	out[1] = (uint8_t)(value >> 8);
+}
+
+static inline void put_le32(uint8_t *out, uint32_t value)
+{
+	put_le16(out, (uint16_t)value);
+	put_le16(out + 2, (uint16_t)(value >> 16));
+}
+
+static inline void put_le64(uint8_t *out, uint64_t value)
+{
+	put_le32(out, (uint32_t)value);
+	put_le32(out + 4, (uint32_t)(value >> 32));
+}
+
+static inline void put_lef32(uint8_t *out, float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	put_le32(out, bits);
+}
+
+static inline uint16_t get_le16(const uint8_t *in)
+{
+	return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static inline uint32_t get_le32(const uint8_t *in)
+{
+	return get_le16(in) | ((uint32_t)get_le16(in + 2) << 16);
+}
+
+static inline uint64_t get_le64(const uint8_t *in)
+{
+	return get_le32(in) | ((uint64_t)get_le32(in + 4) << 32);
+}
+
+static inline float get_lef32(const uint8_t *in)
+{
+	uint32_t bits = get_le32(in);
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
@@ -32,6 +32,7 @@
 
 #include "decoder.h"
 #include "disasm.h"
+#include "memory.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -40,15 +41,88 @@
  // Initializes the CPU's state
 CPUState* InitCPUState()
 {
-	CPUState *state = calloc(1, sizeof(CPUState));
-	/* Real RAM powers up undefined, but exposing host heap contents as video
-	 * produces nondeterministic garbage and can turn stray execution into
-	 * arbitrary opcodes. Start the emulated address space deterministically. */
-	state->memory = calloc(0x10000, sizeof(uint8_t));
+	return InitCPUStateWithLayout(CPU_LAYOUT_SEPARATE);
+}
+
+// Size of the block backing an inline CPU state
+static size_t inlineBlockSize()
+{
+	return MEMORY_SIZE + ((sizeof(CPUState) + CACHE_LINE_SIZE - 1) & ~(size_t)(CACHE_LINE_SIZE - 1));
+}
+
+// Initializes the CPU's state with a particular allocation layout
+CPUState* InitCPUStateWithLayout(CPULayout layout)
+{
+	CPUState *state;
+	if (layout == CPU_LAYOUT_SEPARATE)
+	{
+		state = calloc(1, sizeof(CPUState));
+		if (!state)
+			return NULL;
+		/* Real RAM powers up undefined, but exposing host heap contents as video
+		 * produces nondeterministic garbage and can turn stray execution into
+		 * arbitrary opcodes. Start the emulated address space deterministically. */
+		state->memory = calloc(MEMORY_SIZE, sizeof(uint8_t));
+		if (!state->memory)
+		{
+			free(state);
+			return NULL;
+		}
+	}
+	else
+	{
+		// The mapped block is page-aligned and zeroed. Memory goes first so it
+		// stays page-aligned; the state follows on its own cache line.
+		uint8_t *block = memory_map_block(inlineBlockSize(), layout == CPU_LAYOUT_INLINE_HUGE);
+		if (!block)
+			return NULL;
+		state = (CPUState *)(block + MEMORY_SIZE);
+		state->memory = block;
+	}
+	state->layout = (uint8_t)layout;
+	PowerOnCPUState(state);
+	return state;
+}
+
+// Applies the power-on values to a zeroed state
+void PowerOnCPUState(CPUState *state)
+{
 	state->input_ports[0] = 0x0e;
 	state->input_ports[1] = 0x08;
 	state->running = 1;
-	return state;
+}
+
+// Resets the CPU's state in place
+void ResetCPUState(CPUState *state)
+{
+	uint8_t *memory = state->memory;
+	uint8_t layout = state->layout;
+	uint32_t epoch = state->write_epoch;
+
+	memory_clear(memory, MEMORY_SIZE);
+	memset(state, 0, sizeof(CPUState));
+	state->memory = memory;
+	state->layout = layout;
+	// Keep epochs moving forward so nobody tracking writes misses the reset
+	state->write_epoch = epoch;
+	markAllPagesWritten(state);
+	PowerOnCPUState(state);
+}
+
+// Releases the CPU's state
+void FreeCPUState(CPUState *state)
+{
+	if (!state)
+		return;
+	if (state->layout == CPU_LAYOUT_SEPARATE)
+	{
+		free(state->memory);
+		free(state);
+	}
+	else if (state->layout != CPU_LAYOUT_ARENA && state->layout != CPU_LAYOUT_ARENA_HUGE)
+	{
+		memory_unmap_block(state->memory, inlineBlockSize(), state->layout == CPU_LAYOUT_INLINE_HUGE);
+	}
 }
 
 // Run the fetch execute cycle
@@ -66,8 +140,8 @@ void raiseInterrupt(CPUState *state, int interruptCode)
 {
 	state->halted = 0;
 	// Push PC to the stack
-	state->memory[state->sp - 1] = ((state->pc & 0xff00) >> 8);
-	state->memory[state->sp - 2] = (state->pc & 0xff);
+	setMemoryOffset(state, (uint16_t)(state->sp - 1), (uint8_t)((state->pc & 0xff00) >> 8));
+	setMemoryOffset(state, (uint16_t)(state->sp - 2), (uint8_t)(state->pc & 0xff));
 	state->sp -= 2;
 
 	// Set PC to the interrupt handler
@@ -127,9 +201,29 @@ uint8_t fetchFromMemory(uint8_t *memory, uint16_t offs)
 }
 
 // Sets a memory offset to a value
-void setMemoryOffset(uint8_t *memory, uint16_t offs, uint8_t value)
+void setMemoryOffset(CPUState *state, uint16_t offs, uint8_t value)
+{
+	state->memory[offs] = value;
+	state->page_written[offs >> MEMORY_PAGE_SHIFT] = state->write_epoch;
+}
+
+// Starts a new write epoch
+uint32_t beginWriteEpoch(CPUState *state)
+{
+	return ++state->write_epoch;
+}
+
+// Tests whether a page was written since an epoch
+int pageWrittenSince(CPUState *state, int page, uint32_t epoch)
+{
+	return state->page_written[page] >= epoch;
+}
+
+// Stamps every page as written
+void markAllPagesWritten(CPUState *state)
 {
-	memory[offs] = value;
+	for (int page = 0; page < MEMORY_PAGES; ++page)
+		state->page_written[page] = state->write_epoch;
 }
 
 // Encodes the CPU flags as a bitstream
@@ -226,7 +320,7 @@ void loadFileIntoMemoryAtOffset(CPUState *state, char *file, uint32_t offset)
 			}
 			if (value > 0xff)
 				break;
-			if (address >= 0x10000)
+			if (address >= MEMORY_SIZE)
 			{
 				printf("[ERROR]: Byte array in %s is too large\n", file);
 				free(file_data);
@@ -238,7 +332,7 @@ void loadFileIntoMemoryAtOffset(CPUState *state, char *file, uint32_t offset)
 	}
 	else
 	{
-		if ((uint32_t)fsize > 0x10000 - offset)
+		if ((uint32_t)fsize > MEMORY_SIZE - offset)
 		{
 			printf("[ERROR]: %s does not fit in emulated memory\n", file);
 			free(file_data);
@@ -246,5 +340,6 @@ void loadFileIntoMemoryAtOffset(CPUState *state, char *file, uint32_t offset)
 		}
 		memcpy(&state->memory[offset], file_data, (size_t)fsize);
 	}
+	markAllPagesWritten(state);
 	free(file_data);
 }
@@ -29,6 +29,8 @@
 
 #pragma once
 
+#include "memory.h"
+
 #include <stdint.h>
 
  // The CPU Flags
@@ -40,8 +42,23 @@ typedef struct ConditionCodes {
 	uint8_t ac : 1; // Auxilary Carry
 } ConditionCodes;
 
-// Tracks the current state of the CPU
+// How the CPU state is placed relative to the memory it addresses
+typedef enum CPULayout {
+	CPU_LAYOUT_SEPARATE, // State and memory are independent heap allocations
+	CPU_LAYOUT_INLINE, // State sits directly behind memory in one mapped block
+	CPU_LAYOUT_INLINE_HUGE, // As above, backed by huge pages where available
+	CPU_LAYOUT_ARENA, // Carved from a CPUArena and returned with arena_release()
+	CPU_LAYOUT_ARENA_HUGE // As above, from an arena backed by huge pages
+} CPULayout;
+
+// Tracks the current state of the CPU.
+//
+// Everything the interpreter touches on each instruction comes first so that
+// it shares a single cache line; port and bookkeeping fields follow.
 typedef struct CPUState {
+	uint8_t *memory;
+	uint16_t pc;
+	uint16_t sp;
 	uint8_t	a;
 	uint8_t b;
 	uint8_t c;
@@ -49,17 +66,19 @@ typedef struct CPUState {
 	uint8_t e;
 	uint8_t h;
 	uint8_t l;
-	uint16_t sp;
-	uint16_t pc;
-	uint8_t *memory;
 	struct ConditionCodes cc; // CPU Flags
 	uint8_t int_enable; // Tracks if interrupts are enables or disabled
+	uint8_t halted;
+	uint8_t running;
 	uint8_t input_ports[4];
 	uint8_t output_ports[8];
 	uint16_t shift_register;
 	uint8_t shift_offset;
-	uint8_t running;
-	uint8_t halted;
+	uint8_t layout; // The CPULayout the state was allocated with
+	uint16_t frame_instruction; // Position in the frame, kept by frame_step()
+	uint32_t write_epoch; // Stamped onto each page as it is written
+	uint32_t page_written[MEMORY_PAGES]; // Epoch of the last write to each page
+	struct SoundQueue *sound_events; // Where changes to the sound ports go, or NULL
 } CPUState;
 
 /**
@@ -67,6 +86,32 @@ typedef struct CPUState {
  */
 CPUState* InitCPUState();
 
+/**
+ * Initializes the CPU state using the given allocation layout.
+ *
+ * The inline layouts place the state immediately after the 64 KB address
+ * space in one page-aligned block, so registers and RAM never live in
+ * unrelated heap allocations. Returns NULL if the memory can't be allocated.
+ */
+CPUState* InitCPUStateWithLayout(CPULayout layout);
+
+/**
+ * Releases a CPU state and the memory it addresses. States that came from an
+ * arena belong to it and are left alone.
+ */
+void FreeCPUState(CPUState *state);
+
+/**
+ * Returns the CPU to its power-on state, clearing registers, ports and the
+ * whole address space while keeping the memory it already owns.
+ */
+void ResetCPUState(CPUState *state);
+
+/**
+ * Applies the power-on register and port values to a zeroed CPU state.
+ */
+void PowerOnCPUState(CPUState *state);
+
 /**
  * Runs the CPU's fetch-execute cycle.
  */
@@ -113,9 +158,27 @@ uint16_t buildMemoryOffset(uint8_t hi, uint8_t lo);
 uint8_t fetchFromMemory(uint8_t *memory, uint16_t offs);
 
 /**
- * Sets a value in memory at offset.
+ * Sets a value in memory at offset. Every guest write goes through here so the
+ * page it lands in is stamped with the current write epoch.
+ */
+void setMemoryOffset(CPUState *state, uint16_t offs, uint8_t value);
+
+/**
+ * Starts a new write epoch and returns it. A consumer that keeps the returned
+ * value can later ask which pages were written after this call; any number
+ * of consumers can do so independently.
+ */
+uint32_t beginWriteEpoch(CPUState *state);
+
+/**
+ * Tests whether a page was written at or after the given epoch.
+ */
+int pageWrittenSince(CPUState *state, int page, uint32_t epoch);
+
+/**
+ * Stamps every page as written, for code that replaces memory wholesale.
  */
-void setMemoryOffset(uint8_t *memory, uint16_t offs, uint8_t value);
+void markAllPagesWritten(CPUState *state);
 
 /**
  * Encodes the CPU flags into a bitstream.
@@ -36,9 +36,9 @@ void mov_r2r(uint8_t *dest, uint8_t *src)
 }
 
 // MOV from register to memory
-void mov_r2m(uint8_t *memory, uint8_t *src, uint8_t *h, uint8_t *l)
+void mov_r2m(CPUState *state, uint8_t *src, uint8_t *h, uint8_t *l)
 {
-	setMemoryOffset(memory, buildMemoryOffset(*h, *l), *src);
+	setMemoryOffset(state, buildMemoryOffset(*h, *l), *src);
 }
 
 // MOV from memory to register
@@ -57,7 +57,7 @@ void mvi(uint8_t *reg, uint16_t *pc, unsigned char *opcode)
 // MVI (move immediate) to memory
 void mvi_m(CPUState *state, unsigned char *opcode)
 {
-	setMemoryOffset(state->memory, buildMemoryOffset(state->h, state->l),
+	setMemoryOffset(state, buildMemoryOffset(state->h, state->l),
 		opcode[1]);
 	state->pc++;
 }
@@ -95,7 +95,7 @@ void ldax(uint8_t *a, uint8_t *hi, uint8_t *lo, uint8_t *memory,
 // STA (store a direct)
 void sta(CPUState *state, unsigned char *opcode)
 {
-	setMemoryOffset(state->memory, buildMemoryOffset(opcode[2], opcode[1]),
+	setMemoryOffset(state, buildMemoryOffset(opcode[2], opcode[1]),
 		state->a);
 	state->pc += 2;
 }
@@ -104,8 +104,8 @@ void sta(CPUState *state, unsigned char *opcode)
 void shld(CPUState *state, unsigned char *opcode)
 {
 	uint16_t address = buildMemoryOffset(opcode[2], opcode[1]);
-	setMemoryOffset(state->memory, address, state->l);
-	setMemoryOffset(state->memory, (uint16_t)(address + 1), state->h);
+	setMemoryOffset(state, address, state->l);
+	setMemoryOffset(state, (uint16_t)(address + 1), state->h);
 	state->pc += 2;
 }
 
@@ -119,18 +119,18 @@ void lhld(CPUState *state, unsigned char *opcode)
 }
 
 // PUSH 
-void push(uint8_t *hi, uint8_t *lo, uint16_t *sp, uint8_t *memory)
+void push(uint8_t *hi, uint8_t *lo, CPUState *state)
 {
-	setMemoryOffset(memory, *sp - 2, *hi);
-	setMemoryOffset(memory, *sp - 1, *lo);
-	*sp -= 2;
+	setMemoryOffset(state, state->sp - 2, *hi);
+	setMemoryOffset(state, state->sp - 1, *lo);
+	state->sp -= 2;
 }
 
 // PUSH PSW
 void push_psw(CPUState *state)
 {
-	setMemoryOffset(state->memory, state->sp - 1, state->a);
-	setMemoryOffset(state->memory, state->sp - 2, encodeFlags(state));
+	setMemoryOffset(state, state->sp - 1, state->a);
+	setMemoryOffset(state, state->sp - 2, encodeFlags(state));
 	state->sp -= 2;
 }
 
@@ -163,6 +163,6 @@ void xthl(CPUState *state)
 	uint8_t old_h = state->h;
 	state->l = fetchFromMemory(state->memory, state->sp);
 	state->h = fetchFromMemory(state->memory, (uint16_t)(state->sp + 1));
-	setMemoryOffset(state->memory, state->sp, old_l);
-	setMemoryOffset(state->memory, (uint16_t)(state->sp + 1), old_h);
+	setMemoryOffset(state, state->sp, old_l);
+	setMemoryOffset(state, (uint16_t)(state->sp + 1), old_h);
 }
@@ -46,7 +46,7 @@ void mov_r2r(uint8_t *dest, uint8_t *src);
  * RTN:
  *		(HL) <- src
  */
-void mov_r2m(uint8_t *memory, uint8_t *src, uint8_t *h, uint8_t *l);
+void mov_r2m(CPUState *state, uint8_t *src, uint8_t *h, uint8_t *l);
 
 /**
  * Performs a MOV (move) from memory to a register
@@ -139,7 +139,7 @@ void lhld(CPUState *state, unsigned char *opcode);
  *		(SP - 1) <- lo
  *		SP <- SP + 2
  */
-void push(uint8_t *hi, uint8_t *lo, uint16_t *sp, uint8_t *memory);
+void push(uint8_t *hi, uint8_t *lo, CPUState *state);
 
 /**
  * Performs a PUSH PSW instruction.
@@ -0,0 +1,429 @@
+/*******************************************************************************
+ * File: debugger.c
+ *
+ * Purpose:
+ *		Implementation of the time-travel debugger.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#include "debugger.h"
+
+#include "disasm.h"
+#include "frame.h"
+#include "memory.h"
+#include "snapshot.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NOT_FOUND UINT64_MAX
+
+typedef struct Checkpoint {
+	uint64_t time;
+	uint8_t *data;
+	size_t size;
+	size_t keyframe; // Index of the checkpoint holding the keyframe it needs
+} Checkpoint;
+
+struct Debugger {
+	CPUState *state;
+	Movie *movie;
+	uint64_t time; // Instructions executed since the start
+	uint64_t frontier; // Furthest point reached so far
+	Snapshotter *snapshotter;
+	uint8_t *capture; // Scratch space for snapshot_capture()
+	Checkpoint *checkpoints;
+	size_t checkpoint_count;
+	size_t checkpoint_capacity;
+	size_t last_keyframe;
+	GoldenSnapshot *probe; // Save point for trying an instruction out
+	uint64_t *candidates; // Possible writes found while searching back
+	size_t candidate_count;
+	size_t candidate_capacity;
+};
+
+// Snapshots the machine at the start of a checkpoint interval
+static void add_checkpoint(Debugger *debugger)
+{
+	Checkpoint *checkpoint;
+	size_t size;
+
+	if (debugger->checkpoint_count &&
+		debugger->checkpoints[debugger->checkpoint_count - 1].time >= debugger->time)
+		return;
+	if (debugger->checkpoint_count == debugger->checkpoint_capacity)
+	{
+		size_t capacity = debugger->checkpoint_capacity ? debugger->checkpoint_capacity * 2 : 256;
+		Checkpoint *checkpoints = realloc(debugger->checkpoints, capacity * sizeof(Checkpoint));
+		if (!checkpoints)
+			return;
+		debugger->checkpoints = checkpoints;
+		debugger->checkpoint_capacity = capacity;
+	}
+
+	size = snapshot_capture(debugger->snapshotter, debugger->state, debugger->capture);
+	checkpoint = &debugger->checkpoints[debugger->checkpoint_count];
+	checkpoint->data = malloc(size);
+	if (!checkpoint->data)
+	{
+		// The next capture has to stand on its own.
+		snapshot_force_keyframe(debugger->snapshotter);
+		return;
+	}
+	memcpy(checkpoint->data, debugger->capture, size);
+	checkpoint->size = size;
+	checkpoint->time = debugger->time;
+	if (snapshot_is_keyframe(checkpoint->data, size))
+		debugger->last_keyframe = debugger->checkpoint_count;
+	checkpoint->keyframe = debugger->last_keyframe;
+	debugger->checkpoint_count++;
+}
+
+// Runs the instruction at the current point the way the main loop would,
+// applying the movie's input at the start of each frame, without moving on
+static void run_instruction(Debugger *debugger)
+{
+	int instruction = (int)(debugger->time % FRAME_INSTRUCTIONS);
+	if (instruction == 0 && debugger->movie)
+		movie_begin_frame(debugger->movie, debugger->state);
+	frame_step(debugger->state, instruction);
+}
+
+// Runs one instruction and moves on
+static void step(Debugger *debugger)
+{
+	CPUState *state = debugger->state;
+
+	if (debugger->time % ((uint64_t)FRAME_INSTRUCTIONS * DEBUGGER_CHECKPOINT_FRAMES) == 0)
+		add_checkpoint(debugger);
+	run_instruction(debugger);
+	debugger->time++;
+	if (debugger->time % FRAME_INSTRUCTIONS == 0 && debugger->movie &&
+		!movie_end_frame(debugger->movie, state) && debugger->time > debugger->frontier)
+		printf("warning: diverged from the recording in frame %llu\n",
+			(unsigned long long)(debugger->time / FRAME_INSTRUCTIONS - 1));
+	if (debugger->time > debugger->frontier)
+		debugger->frontier = debugger->time;
+}
+
+// Finds the last checkpoint at or before a point
+static size_t checkpoint_before(const Debugger *debugger, uint64_t time)
+{
+	size_t low = 0, high = debugger->checkpoint_count;
+	while (high - low > 1)
+	{
+		size_t middle = low + (high - low) / 2;
+		if (debugger->checkpoints[middle].time <= time)
+			low = middle;
+		else
+			high = middle;
+	}
+	return low;
+}
+
+// Puts the machine and movie back to a checkpoint
+static void restore_checkpoint(Debugger *debugger, size_t index)
+{
+	const Checkpoint *checkpoint = &debugger->checkpoints[index];
+	const Checkpoint *keyframe = &debugger->checkpoints[checkpoint->keyframe];
+
+	snapshot_restore(debugger->state, keyframe->data, keyframe->size,
+		checkpoint == keyframe ? NULL : checkpoint->data, checkpoint->size);
+	debugger->time = checkpoint->time;
+	if (debugger->movie)
+		movie_seek(debugger->movie, (uint32_t)(checkpoint->time / FRAME_INSTRUCTIONS));
+}
+
+// Starts debugging
+Debugger *debugger_create(CPUState *state, Movie *movie)
+{
+	Debugger *debugger = calloc(1, sizeof(Debugger));
+	if (!debugger)
+		return NULL;
+	debugger->state = state;
+	debugger->movie = movie;
+	debugger->snapshotter = snapshot_create(DEBUGGER_CHECKPOINT_FRAMES);
+	debugger->capture = malloc(snapshot_max_size());
+	debugger->probe = golden_capture(state);
+	if (!debugger->snapshotter || !debugger->capture || !debugger->probe)
+	{
+		debugger_destroy(debugger);
+		return NULL;
+	}
+	add_checkpoint(debugger);
+	if (!debugger->checkpoint_count)
+	{
+		debugger_destroy(debugger);
+		return NULL;
+	}
+	return debugger;
+}
+
+// Instructions executed so far
+uint64_t debugger_time(const Debugger *debugger)
+{
+	return debugger->time;
+}
+
+// Moves to a point in time
+void debugger_seek(Debugger *debugger, uint64_t time)
+{
+	size_t index = checkpoint_before(debugger, time);
+	if (time < debugger->time || debugger->checkpoints[index].time > debugger->time)
+		restore_checkpoint(debugger, index);
+	while (debugger->time < time)
+		step(debugger);
+}
+
+// Tests whether the next instruction writes an address by running it twice
+// with different values planted there. A write can match at most one of them,
+// so the instruction wrote the address if either value didn't survive.
+static int writes_address(Debugger *debugger, uint16_t address)
+{
+	CPUState *state = debugger->state;
+	uint8_t original = state->memory[address];
+	int written = 0;
+
+	golden_refresh(debugger->probe, state);
+	for (int pass = 0; pass < 2 && !written; ++pass)
+	{
+		uint8_t planted = (uint8_t)(original ^ (pass ? 0xaa : 0x55));
+		setMemoryOffset(state, address, planted);
+		run_instruction(debugger);
+		written = state->memory[address] != planted;
+		golden_restore(debugger->probe, state);
+		// The frame's input has to be applied again when it really runs.
+		if (debugger->movie && debugger->time % FRAME_INSTRUCTIONS == 0)
+			movie_seek(debugger->movie, (uint32_t)(debugger->time / FRAME_INSTRUCTIONS));
+	}
+	return written;
+}
+
+// Remembers an instruction that wrote the address's page without changing it
+static void add_candidate(Debugger *debugger, uint64_t time)
+{
+	if (debugger->candidate_count == debugger->candidate_capacity)
+	{
+		size_t capacity = debugger->candidate_capacity ? debugger->candidate_capacity * 2 : 256;
+		uint64_t *candidates = realloc(debugger->candidates, capacity * sizeof(uint64_t));
+		if (!candidates)
+			return;
+		debugger->candidates = candidates;
+		debugger->candidate_capacity = capacity;
+	}
+	debugger->candidates[debugger->candidate_count++] = time;
+}
+
+// Finds the last write to an address between a checkpoint and a later point
+static uint64_t last_write(Debugger *debugger, size_t index, uint64_t end, uint16_t address)
+{
+	CPUState *state = debugger->state;
+	int page = address >> MEMORY_PAGE_SHIFT;
+	uint64_t found = NOT_FOUND;
+	uint32_t mark;
+
+	// First pass: the page write epochs flag every instruction that wrote the
+	// page. A changed value settles it; anything else might have written the
+	// same value or another address on the page.
+	restore_checkpoint(debugger, index);
+	debugger->candidate_count = 0;
+	mark = beginWriteEpoch(state);
+	while (debugger->time < end)
+	{
+		uint64_t time = debugger->time;
+		uint8_t before = state->memory[address];
+		step(debugger);
+		if (!pageWrittenSince(state, page, mark))
+			continue;
+		if (state->memory[address] != before)
+		{
+			found = time;
+			debugger->candidate_count = 0;
+		}
+		else
+		{
+			add_candidate(debugger, time);
+		}
+		mark = beginWriteEpoch(state);
+	}
+
+	// Second pass: try out the doubtful instructions after the last certain
+	// write.
+	if (debugger->candidate_count)
+	{
+		restore_checkpoint(debugger, index);
+		for (size_t i = 0; i < debugger->candidate_count; ++i)
+		{
+			while (debugger->time < debugger->candidates[i])
+				step(debugger);
+			if (writes_address(debugger, address))
+				found = debugger->candidates[i];
+		}
+	}
+	return found;
+}
+
+// Moves back to the last write to an address
+int debugger_reverse_to_write(Debugger *debugger, uint16_t address)
+{
+	uint64_t start = debugger->time, end = start;
+	size_t index;
+
+	if (start == 0)
+		return 0;
+	index = checkpoint_before(debugger, end - 1);
+	for (;;)
+	{
+		uint64_t found = last_write(debugger, index, end, address);
+		if (found != NOT_FOUND)
+		{
+			debugger_seek(debugger, found);
+			return 1;
+		}
+		if (index == 0)
+			break;
+		end = debugger->checkpoints[index].time;
+		index--;
+	}
+	debugger_seek(debugger, start);
+	return 0;
+}
+
+// Prints where the machine is and the next instruction
+static void print_position(Debugger *debugger)
+{
+	printf("frame %llu + %4d  ", (unsigned long long)(debugger->time / FRAME_INSTRUCTIONS),
+		(int)(debugger->time % FRAME_INSTRUCTIONS));
+	disassembleInstruction(debugger->state->memory, debugger->state->pc);
+	printf("\n");
+}
+
+// Prints the registers
+static void print_registers(CPUState *state)
+{
+	printf("a=%02x bc=%02x%02x de=%02x%02x hl=%02x%02x sp=%04x pc=%04x flags=%02x%s%s\n",
+		state->a, state->b, state->c, state->d, state->e, state->h, state->l,
+		state->sp, state->pc, encodeFlags(state),
+		state->int_enable ? " ei" : "", state->halted ? " halted" : "");
+}
+
+// Prints a range of memory
+static void print_memory(CPUState *state, uint16_t address, unsigned long count)
+{
+	for (unsigned long i = 0; i < count; ++i)
+	{
+		if (i % 16 == 0)
+			printf("%s%04x:", i ? "\n" : "", (uint16_t)(address + i));
+		printf(" %02x", state->memory[(uint16_t)(address + i)]);
+	}
+	printf("\n");
+}
+
+static void print_help(void)
+{
+	printf("s [n]      step n instructions (default 1)\n"
+		"rs [n]     step back n instructions\n"
+		"f [n]      run to the start of the nth next frame\n"
+		"rf [n]     go back to the start of the nth previous frame\n"
+		"g frame    go to the start of a frame\n"
+		"rc addr    go back to just before the last write to a hex address\n"
+		"r          show the registers\n"
+		"x addr [n] show n bytes from a hex address (default 16)\n"
+		"q          quit\n");
+}
+
+// Runs the command console
+void debugger_console(Debugger *debugger, FILE *in)
+{
+	char line[256];
+
+	print_position(debugger);
+	while (printf("> "), fflush(stdout), fgets(line, sizeof(line), in))
+	{
+		char command[8] = "";
+		char argument[32] = "";
+		char count_argument[32] = "";
+		unsigned long count;
+		uint64_t frame = debugger->time / FRAME_INSTRUCTIONS;
+
+		if (sscanf(line, "%7s %31s %31s", command, argument, count_argument) < 1)
+			continue;
+		count = argument[0] ? strtoul(argument, NULL, 10) : 1;
+
+		if (strcmp(command, "q") == 0)
+			break;
+		else if (strcmp(command, "s") == 0)
+			debugger_seek(debugger, debugger->time + count);
+		else if (strcmp(command, "rs") == 0)
+			debugger_seek(debugger, debugger->time > count ? debugger->time - count : 0);
+		else if (strcmp(command, "f") == 0)
+			debugger_seek(debugger, (frame + count) * FRAME_INSTRUCTIONS);
+		else if (strcmp(command, "rf") == 0)
+		{
+			// Going back from the middle of a frame first lands on its start.
+			if (debugger->time % FRAME_INSTRUCTIONS && count)
+				count--;
+			debugger_seek(debugger, (frame > count ? frame - count : 0) * FRAME_INSTRUCTIONS);
+		}
+		else if (strcmp(command, "g") == 0 && argument[0])
+			debugger_seek(debugger, (uint64_t)strtoull(argument, NULL, 10) * FRAME_INSTRUCTIONS);
+		else if (strcmp(command, "rc") == 0 && argument[0])
+		{
+			uint16_t address = (uint16_t)strtoul(argument, NULL, 16);
+			if (!debugger_reverse_to_write(debugger, address))
+				printf("nothing wrote %04x before this point\n", address);
+		}
+		else if (strcmp(command, "r") == 0)
+		{
+			print_registers(debugger->state);
+			continue;
+		}
+		else if (strcmp(command, "x") == 0 && argument[0])
+		{
+			print_memory(debugger->state, (uint16_t)strtoul(argument, NULL, 16),
+				count_argument[0] ? strtoul(count_argument, NULL, 10) : 16);
+			continue;
+		}
+		else
+		{
+			print_help();
+			continue;
+		}
+		print_position(debugger);
+	}
+}
+
+// Releases a debugger
+void debugger_destroy(Debugger *debugger)
+{
+	if (!debugger)
+		return;
+	for (size_t i = 0; i < debugger->checkpoint_count; ++i)
+		free(debugger->checkpoints[i].data);
+	free(debugger->checkpoints);
+	free(debugger->candidates);
+	free(debugger->capture);
+	snapshot_destroy(debugger->snapshotter);
+	golden_destroy(debugger->probe);
+	free(debugger);
+}
@@ -0,0 +1,81 @@
+/*******************************************************************************
+ * File: debugger.h
+ *
+ * Purpose:
+ *		Specification for the time-travel debugger.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "cpu.h"
+#include "movie.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * The debugger runs the machine one instruction at a time and keeps a
+ * snapshot every DEBUGGER_CHECKPOINT_FRAMES frames. Execution is
+ * deterministic given the inputs, so any earlier point is reached by
+ * restoring the nearest checkpoint before it and running forward; going
+ * back never costs more than one checkpoint interval of emulation.
+ */
+#define DEBUGGER_CHECKPOINT_FRAMES 60
+
+typedef struct Debugger Debugger;
+
+/**
+ * Starts debugging the CPU state from its current point, which counts as
+ * instruction zero. Inputs come from the movie if one is given (positioned at
+ * its first frame), otherwise the input ports stay as they are.
+ */
+Debugger *debugger_create(CPUState *state, Movie *movie);
+
+/**
+ * Instructions executed since the debugger started.
+ */
+uint64_t debugger_time(const Debugger *debugger);
+
+/**
+ * Moves to the point where the given number of instructions have executed,
+ * forwards or backwards.
+ */
+void debugger_seek(Debugger *debugger, uint64_t time);
+
+/**
+ * Moves back to just before the last instruction that wrote the address,
+ * counting interrupt pushes. Returns 0 and stays put if nothing before the
+ * current point wrote it.
+ */
+int debugger_reverse_to_write(Debugger *debugger, uint16_t address);
+
+/**
+ * Reads commands from a console until it quits or the input ends.
+ */
+void debugger_console(Debugger *debugger, FILE *in);
+
+/**
+ * Releases a debugger. The CPU state and movie stay with the caller.
+ */
+void debugger_destroy(Debugger *debugger);
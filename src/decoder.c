@@ -245,11 +245,21 @@ int decode(CPUState *state)
 		break;
 	case 0x34:
 		// INR M
-		inr(state, &state->memory[buildMemoryOffset(state->h, state->l)]);
+		{
+			uint16_t offs = buildMemoryOffset(state->h, state->l);
+			uint8_t value = fetchFromMemory(state->memory, offs);
+			inr(state, &value);
+			setMemoryOffset(state, offs, value);
+		}
 		break;
 	case 0x35:
 		// DCR M
-		dcr(state, &state->memory[buildMemoryOffset(state->h, state->l)], opcode);
+		{
+			uint16_t offs = buildMemoryOffset(state->h, state->l);
+			uint8_t value = fetchFromMemory(state->memory, offs);
+			dcr(state, &value, opcode);
+			setMemoryOffset(state, offs, value);
+		}
 		break;
 	case 0x36:
 		// MVI M, D8
@@ -486,27 +496,27 @@ int decode(CPUState *state)
 		break;
 	case 0x70:
 		// MOV M, B
-		mov_r2m(state->memory, &state->b, &state->h, &state->l);
+		mov_r2m(state, &state->b, &state->h, &state->l);
 		break;
 	case 0x71:
 		// MOV M, C
-		mov_r2m(state->memory, &state->c, &state->h, &state->l);
+		mov_r2m(state, &state->c, &state->h, &state->l);
 		break;
 	case 0x72:
 		// MOV M, D
-		mov_r2m(state->memory, &state->d, &state->h, &state->l);
+		mov_r2m(state, &state->d, &state->h, &state->l);
 		break;
 	case 0x73:
 		// MOV M, E
-		mov_r2m(state->memory, &state->e, &state->h, &state->l);
+		mov_r2m(state, &state->e, &state->h, &state->l);
 		break;
 	case 0x74:
 		// MOV M, H
-		mov_r2m(state->memory, &state->h, &state->h, &state->l);
+		mov_r2m(state, &state->h, &state->h, &state->l);
 		break;
 	case 0x75:
 		// MOV M, L
-		mov_r2m(state->memory, &state->l, &state->h, &state->l);
+		mov_r2m(state, &state->l, &state->h, &state->l);
 		break;
 	case 0x76:
 		// HLT
@@ -514,7 +524,7 @@ int decode(CPUState *state)
 		break;
 	case 0x77:
 		// MOV M, A
-		mov_r2m(state->memory, &state->a, &state->h, &state->l);
+		mov_r2m(state, &state->a, &state->h, &state->l);
 		break;
 	case 0x78:
 		// MOV A, B
@@ -832,7 +842,7 @@ int decode(CPUState *state)
 		break;
 	case 0xc5:
 		// PUSH B
-		push(&state->c, &state->b, &state->sp, state->memory);
+		push(&state->c, &state->b, state);
 		break;
 	case 0xc6:
 		// ADI D8
@@ -896,7 +906,7 @@ int decode(CPUState *state)
 		break;
 	case 0xd5:
 		// PUSH D
-		push(&state->e, &state->d, &state->sp, state->memory);
+		push(&state->e, &state->d, state);
 		break;
 	case 0xd6:
 		// SUI D8
@@ -957,7 +967,7 @@ int decode(CPUState *state)
 		break;
 	case 0xe5:
 		// PUSH H
-		push(&state->l, &state->h, &state->sp, state->memory);
+		push(&state->l, &state->h, state);
 		break;
 	case 0xe6:
 		// ANI D8
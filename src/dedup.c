@@ -0,0 +1,312 @@
+/*******************************************************************************
+ * File: dedup.c
+ *
+ * Purpose:
+ *		Shares identical pages of emulated memory between CPU states.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#include "dedup.h"
+
+#include "hash.h"
+#include "memory.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+// A page of some CPU state's memory waiting to be matched
+typedef struct PageRef {
+	uint64_t hash;
+	uint8_t *page;
+} PageRef;
+
+struct PagePool {
+	int fd; // Backing file the frames live in
+	uint8_t *frames; // Shared view of every frame
+	size_t frame_count;
+	size_t frame_capacity;
+	uint64_t *index_hashes; // Open-addressed index of frames by content hash
+	uint32_t *index_frames;
+	size_t index_size;
+};
+
+static uint8_t zero_frame[MEMORY_FRAME_SIZE];
+
+// Opens an anonymous file to hold the frames
+static int open_pool_file(void)
+{
+	FILE *file;
+	int fd;
+#if defined(__linux__) && defined(SYS_memfd_create)
+	fd = (int)syscall(SYS_memfd_create, "8080-pages", 1u /* MFD_CLOEXEC */);
+	if (fd >= 0)
+		return fd;
+#endif
+	file = tmpfile();
+	if (!file)
+		return -1;
+	fd = dup(fileno(file));
+	fclose(file);
+	return fd;
+}
+
+// Creates an empty pool
+PagePool *pagepool_create(void)
+{
+	PagePool *pool = calloc(1, sizeof(PagePool));
+	if (!pool)
+		return NULL;
+	pool->fd = open_pool_file();
+	if (pool->fd < 0)
+	{
+		free(pool);
+		return NULL;
+	}
+	return pool;
+}
+
+static int compare_refs(const void *a, const void *b)
+{
+	uint64_t x = ((const PageRef *)a)->hash;
+	uint64_t y = ((const PageRef *)b)->hash;
+	return (x > y) - (x < y);
+}
+
+// Finds the frame holding a page's contents, or -1
+static long find_frame(PagePool *pool, uint64_t hash, const uint8_t *page)
+{
+	if (pool->index_size == 0)
+		return -1;
+	for (size_t i = hash & (pool->index_size - 1); pool->index_frames[i] != UINT32_MAX;
+		i = (i + 1) & (pool->index_size - 1))
+	{
+		uint32_t frame = pool->index_frames[i];
+		if (pool->index_hashes[i] == hash &&
+			memcmp(pool->frames + (size_t)frame * MEMORY_FRAME_SIZE, page, MEMORY_FRAME_SIZE) == 0)
+			return frame;
+	}
+	return -1;
+}
+
+static void index_frame(PagePool *pool, uint64_t hash, uint32_t frame)
+{
+	size_t i = hash & (pool->index_size - 1);
+	while (pool->index_frames[i] != UINT32_MAX)
+		i = (i + 1) & (pool->index_size - 1);
+	pool->index_hashes[i] = hash;
+	pool->index_frames[i] = frame;
+}
+
+// Makes room for another frame, growing the file, its view and the index
+static int reserve_frame(PagePool *pool)
+{
+	if (pool->frame_count == pool->frame_capacity)
+	{
+		size_t capacity = pool->frame_capacity ? pool->frame_capacity * 2 : 64;
+		uint8_t *frames;
+		if (ftruncate(pool->fd, (off_t)(capacity * MEMORY_FRAME_SIZE)) != 0)
+			return 0;
+		frames = mmap(NULL, capacity * MEMORY_FRAME_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, pool->fd, 0);
+		if (frames == MAP_FAILED)
+			return 0;
+		if (pool->frames)
+			munmap(pool->frames, pool->frame_capacity * MEMORY_FRAME_SIZE);
+		pool->frames = frames;
+		pool->frame_capacity = capacity;
+	}
+	if ((pool->frame_count + 1) * 2 > pool->index_size)
+	{
+		size_t size = pool->index_size ? pool->index_size * 2 : 128;
+		uint64_t *hashes = malloc(size * sizeof(uint64_t));
+		uint32_t *frames = malloc(size * sizeof(uint32_t));
+		uint64_t *old_hashes = pool->index_hashes;
+		uint32_t *old_frames = pool->index_frames;
+		size_t old_size = pool->index_size;
+		if (!hashes || !frames)
+		{
+			free(hashes);
+			free(frames);
+			return 0;
+		}
+		memset(frames, 0xff, size * sizeof(uint32_t));
+		pool->index_hashes = hashes;
+		pool->index_frames = frames;
+		pool->index_size = size;
+		for (size_t i = 0; i < old_size; ++i)
+			if (old_frames[i] != UINT32_MAX)
+				index_frame(pool, old_hashes[i], old_frames[i]);
+		free(old_hashes);
+		free(old_frames);
+	}
+	return 1;
+}
+
+// Copies a page into a new frame
+static long add_frame(PagePool *pool, uint64_t hash, const uint8_t *page)
+{
+	uint32_t frame;
+	if (!reserve_frame(pool))
+		return -1;
+	frame = (uint32_t)pool->frame_count++;
+	memcpy(pool->frames + (size_t)frame * MEMORY_FRAME_SIZE, page, MEMORY_FRAME_SIZE);
+	index_frame(pool, hash, frame);
+	return frame;
+}
+
+// Points a page of guest memory at a frame (or the zero page when frame < 0)
+static int map_page(PagePool *pool, uint8_t *page, long frame)
+{
+	void *mapped;
+	if (frame < 0)
+		mapped = mmap(page, MEMORY_FRAME_SIZE, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+	else
+		mapped = mmap(page, MEMORY_FRAME_SIZE, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_FIXED, pool->fd, (off_t)frame * MEMORY_FRAME_SIZE);
+	return mapped != MAP_FAILED;
+}
+
+// Shares identical pages between CPU states
+int pagepool_dedup(PagePool *pool, CPUState **states, size_t count, DedupStats *stats)
+{
+	static uint64_t zero_hash;
+	PageRef *refs = malloc(count * MEMORY_FRAMES * sizeof(PageRef));
+	size_t ref_count = 0;
+	int result = 0;
+
+	memset(stats, 0, sizeof(*stats));
+	if (!refs)
+		return -1;
+	if (!zero_hash)
+		zero_hash = hash_bytes(zero_frame, MEMORY_FRAME_SIZE);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		CPUState *state = states[i];
+		if (state->layout == CPU_LAYOUT_SEPARATE || state->layout == CPU_LAYOUT_INLINE_HUGE ||
+			state->layout == CPU_LAYOUT_ARENA_HUGE ||
+			((uintptr_t)state->memory & (MEMORY_FRAME_SIZE - 1)))
+			continue;
+		for (size_t f = 0; f < MEMORY_FRAMES; ++f)
+		{
+			uint8_t *page = state->memory + f * MEMORY_FRAME_SIZE;
+			refs[ref_count].hash = hash_bytes(page, MEMORY_FRAME_SIZE);
+			refs[ref_count].page = page;
+			ref_count++;
+		}
+	}
+	stats->pages_scanned = ref_count;
+
+	// Equal contents hash equally, so sorting brings each candidate set together
+	qsort(refs, ref_count, sizeof(PageRef), compare_refs);
+	for (size_t start = 0, end; start < ref_count && result == 0; start = end)
+	{
+		uint64_t hash = refs[start].hash;
+		const uint8_t *leader = refs[start].page;
+		long frame;
+		int zero;
+		for (end = start + 1; end < ref_count && refs[end].hash == hash; ++end)
+			;
+		zero = hash == zero_hash && memcmp(leader, zero_frame, MEMORY_FRAME_SIZE) == 0;
+		frame = zero ? -1 : find_frame(pool, hash, leader);
+		// A page only seen once isn't worth a frame of its own
+		if (!zero && frame < 0)
+		{
+			if (end - start < 2)
+				continue;
+			frame = add_frame(pool, hash, leader);
+			if (frame < 0)
+			{
+				result = -1;
+				break;
+			}
+		}
+		if (!zero)
+			stats->frames_used++;
+		for (size_t i = start; i < end; ++i)
+		{
+			// A hash collision leaves the odd page out private
+			if (i != start && memcmp(refs[i].page, leader, MEMORY_FRAME_SIZE) != 0)
+				continue;
+			if (!map_page(pool, refs[i].page, frame))
+			{
+				result = -1;
+				break;
+			}
+			stats->pages_shared++;
+		}
+	}
+
+	stats->pool_frames = pool->frame_count;
+	if (stats->pages_shared > stats->frames_used)
+		stats->bytes_saved = (stats->pages_shared - stats->frames_used) * MEMORY_FRAME_SIZE;
+	free(refs);
+	return result;
+}
+
+// Releases the pool
+void pagepool_destroy(PagePool *pool)
+{
+	if (!pool)
+		return;
+	if (pool->frames)
+		munmap(pool->frames, pool->frame_capacity * MEMORY_FRAME_SIZE);
+	close(pool->fd);
+	free(pool->index_hashes);
+	free(pool->index_frames);
+	free(pool);
+}
+
+#else
+
+// Windows has no copy-on-write file views that can replace part of an
+// existing allocation, so pages are never shared there.
+PagePool *pagepool_create(void)
+{
+	return NULL;
+}
+
+int pagepool_dedup(PagePool *pool, CPUState **states, size_t count, DedupStats *stats)
+{
+	(void)pool;
+	(void)states;
+	(void)count;
+	memset(stats, 0, sizeof(*stats));
+	return -1;
+}
+
+void pagepool_destroy(PagePool *pool)
+{
+	(void)pool;
+}
+
+#endif
@@ -0,0 +1,70 @@
+/*******************************************************************************
+ * File: dedup.h
+ *
+ * Purpose:
+ *		Specification for sharing identical pages of emulated memory between
+ *		CPU states.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "cpu.h"
+
+#include <stddef.h>
+
+typedef struct PagePool PagePool;
+
+// What a deduplication pass found
+typedef struct DedupStats {
+	size_t pages_scanned; // Pages looked at
+	size_t pages_shared; // Pages now backed by a shared frame or the zero page
+	size_t frames_used; // Distinct pool frames backing those pages
+	size_t pool_frames; // Frames held by the pool, including unused ones
+	size_t bytes_saved; // Compared with every scanned page being private
+} DedupStats;
+
+/**
+ * Creates an empty pool of shared frames. Returns NULL where the host can't
+ * share memory copy-on-write.
+ */
+PagePool *pagepool_create(void);
+
+/**
+ * Finds byte-identical MEMORY_FRAME_SIZE pages across the given CPU states
+ * and remaps each set onto one copy-on-write frame of the pool; pages that
+ * are entirely zero go back to the host's zero page. The guest keeps seeing a
+ * flat address space, and the first write to a shared page gives that state
+ * a private copy again.
+ *
+ * Only states from the inline or arena layouts take part, since their
+ * address spaces are page-aligned mappings; huge pages can't be split, so
+ * states from CPU_LAYOUT_INLINE_HUGE and huge arenas are skipped. Returns -1
+ * if a remap fails; the pages handled so far stay shared.
+ */
+int pagepool_dedup(PagePool *pool, CPUState **states, size_t count, DedupStats *stats);
+
+/**
+ * Releases the pool. Pages already sharing its frames keep working.
+ */
+void pagepool_destroy(PagePool *pool);
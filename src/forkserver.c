@@ -0,0 +1,87 @@
+/*******************************************************************************
+ * File: forkserver.c
+ *
+ * Purpose:
+ *		Implementation of the AFL-style fork server.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#include "forkserver.h"
+
+#ifdef _WIN32
+
+int forkserver_run(void)
+{
+	return 0;
+}
+
+#else
+
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Writes a 32-bit word to the status pipe
+static int send_word(uint32_t word)
+{
+	return write(FORKSERVER_STATUS_FD, &word, sizeof(word)) == (ssize_t)sizeof(word);
+}
+
+// Serves fork requests until the controller goes away
+int forkserver_run(void)
+{
+	uint32_t request;
+	ssize_t got;
+
+	// The hello message doubles as the check that a controller is there.
+	if (!send_word(0))
+		return 0;
+
+	while ((got = read(FORKSERVER_CONTROL_FD, &request, sizeof(request))) == (ssize_t)sizeof(request))
+	{
+		pid_t child;
+		int status;
+
+		fflush(NULL);
+		child = fork();
+		if (child < 0)
+			return -1;
+		if (child == 0)
+		{
+			close(FORKSERVER_CONTROL_FD);
+			close(FORKSERVER_STATUS_FD);
+			return 1;
+		}
+		if (!send_word((uint32_t)child))
+			return -1;
+		if (waitpid(child, &status, 0) < 0)
+			return -1;
+		if (!send_word((uint32_t)status))
+			return -1;
+	}
+	return got == 0 ? 2 : -1;
+}
+
+#endif
@@ -0,0 +1,46 @@
+/*******************************************************************************
+ * File: forkserver.h
+ *
+ * Purpose:
+ *		Specification for the AFL-style fork server.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+/* Descriptors the controlling process passes in, as in AFL. */
+#define FORKSERVER_CONTROL_FD 198
+#define FORKSERVER_STATUS_FD (FORKSERVER_CONTROL_FD + 1)
+
+/**
+ * Hands the current process over to a fork server. Each 4-byte request on the
+ * control pipe forks a child that inherits the process as it is now; the pid
+ * and then the child's wait status are written back on the status pipe.
+ *
+ * Returns 1 in each child, which should run to completion and exit. Returns 0
+ * if nothing is listening on the status pipe, in which case the caller simply
+ * carries on. Returns 2 in the server once the controller hangs up, which is
+ * how a session normally ends, and -1 if a fork or either pipe fails. Always
+ * returns 0 where fork() isn't available.
+ */
+int forkserver_run(void);
@@ -0,0 +1,54 @@
+/*******************************************************************************
+ * File: frame.h
+ *
+ * Purpose:
+ *		How the Space Invaders board drives the CPU through a video frame.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "cpu.h"
+
+/* Instructions per 60 Hz frame: about 2 MHz at the 8080's typical
+ * instruction length. */
+#define FRAME_INSTRUCTIONS 7000
+
+/* Instructions up to and including the one after which RST 1 is raised. The
+ * beam has drawn the first half of the screen by then. */
+#define FRAME_MID_INSTRUCTIONS (FRAME_INSTRUCTIONS / 2)
+
+/**
+ * Runs the given instruction of a frame. The video hardware raises RST 1 at
+ * mid-frame and RST 2 at vertical blank, so running instructions 0 to
+ * FRAME_INSTRUCTIONS - 1 in order is exactly one frame. Anything that needs to
+ * reproduce a frame instruction by instruction goes through here.
+ */
+static inline void frame_step(CPUState *state, int instruction)
+{
+	state->frame_instruction = (uint16_t)instruction;
+	runCPUCycle(state);
+	if ((instruction == FRAME_MID_INSTRUCTIONS - 1 || instruction == FRAME_INSTRUCTIONS - 1) &&
+		state->int_enable)
+		raiseInterrupt(state, instruction < FRAME_MID_INSTRUCTIONS ? 1 : 2);
+}
@@ -0,0 +1,222 @@
+/*******************************************************************************
+ * File: framedump.c
+ *
+ * Purpose:
+ *		Implementation of dumping frames to a video file.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#include "framedump.h"
+
+#include "video.h"
+
+#include <SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Frames per batch: big enough that each handoff amortises the locking and
+// the writes, small enough to keep the buffers under a megabyte
+#define BATCH_FRAMES 64
+
+// Video-range luma for dark and lit pixels
+#define LUMA_DARK 16
+#define LUMA_LIT 235
+
+struct FrameDump {
+	FILE *file;
+	int y4m;
+	int every;
+	long offered;
+	uint8_t *batches[2];
+	int current; // Batch being filled
+	int count; // Frames in it so far
+	SDL_Thread *writer;
+	SDL_mutex *lock;
+	SDL_cond *changed;
+	int queued; // Batch handed to the writer, or -1 once it's written
+	int queued_count;
+	int closing;
+	int failed;
+	uint8_t luma[SCREEN_WIDTH * SCREEN_HEIGHT];
+};
+
+// Eight luma bytes for every byte of 8 horizontal pixels, lowest bit leftmost
+static uint8_t expand[256][8];
+static SDL_atomic_t expand_ready;
+
+static void build_expand(void)
+{
+	for (int byte = 0; byte < 256; ++byte)
+		for (int bit = 0; bit < 8; ++bit)
+			expand[byte][bit] = (byte & (1 << bit)) ? LUMA_LIT : LUMA_DARK;
+	SDL_AtomicSet(&expand_ready, 1);
+}
+
+// Converts a frame to upright 8-bit luma. As in video.c, the bytes at the
+// same height in a strip's 8 columns are an 8x8 block of pixels; transposing
+// its bits (Hacker's Delight 7-3) gives a byte per row of 8 pixels.
+static void to_luma(const uint8_t *vram, uint8_t *luma)
+{
+	for (int strip = 0; strip < VIDEO_STRIPS; ++strip)
+	{
+		const uint8_t *column = vram + strip * VIDEO_STRIP_BYTES;
+		for (int k = 0; k < VIDEO_COLUMN_BYTES; ++k)
+		{
+			uint64_t block = 0, t;
+			for (int c = 0; c < 8; ++c)
+				block |= (uint64_t)column[c * VIDEO_COLUMN_BYTES + k] << (8 * c);
+			t = (block ^ (block >> 7)) & 0x00aa00aa00aa00aaull;
+			block ^= t ^ (t << 7);
+			t = (block ^ (block >> 14)) & 0x0000cccc0000ccccull;
+			block ^= t ^ (t << 14);
+			t = (block ^ (block >> 28)) & 0x00000000f0f0f0f0ull;
+			block ^= t ^ (t << 28);
+			for (int bit = 0; bit < 8; ++bit)
+				memcpy(luma + (SCREEN_HEIGHT - 1 - 8 * k - bit) * SCREEN_WIDTH + strip * VIDEO_STRIP_COLUMNS,
+					expand[(block >> (8 * bit)) & 0xff], 8);
+		}
+	}
+}
+
+// Writes a batch of frames
+static int write_batch(FrameDump *dump, const uint8_t *batch, int count)
+{
+	if (!dump->y4m)
+		return fwrite(batch, VIDEO_BYTES, (size_t)count, dump->file) == (size_t)count ? 0 : -1;
+	for (int frame = 0; frame < count; ++frame)
+	{
+		to_luma(batch + (size_t)frame * VIDEO_BYTES, dump->luma);
+		if (fputs("FRAME\n", dump->file) == EOF ||
+			fwrite(dump->luma, sizeof(dump->luma), 1, dump->file) != 1)
+			return -1;
+	}
+	return 0;
+}
+
+// Writes each batch handed over until the dump is closed
+static int writer_main(void *data)
+{
+	FrameDump *dump = data;
+	SDL_LockMutex(dump->lock);
+	for (;;)
+	{
+		int batch, count;
+		while (dump->queued < 0 && !dump->closing)
+			SDL_CondWait(dump->changed, dump->lock);
+		if (dump->queued < 0)
+			break;
+		batch = dump->queued;
+		count = dump->queued_count;
+		SDL_UnlockMutex(dump->lock);
+		if (!dump->failed && write_batch(dump, dump->batches[batch], count) != 0)
+			dump->failed = 1;
+		SDL_LockMutex(dump->lock);
+		dump->queued = -1;
+		SDL_CondBroadcast(dump->changed);
+	}
+	SDL_UnlockMutex(dump->lock);
+	return 0;
+}
+
+// Hands the current batch to the writer and switches to the other one
+static void hand_off(FrameDump *dump)
+{
+	SDL_LockMutex(dump->lock);
+	while (dump->queued >= 0)
+		SDL_CondWait(dump->changed, dump->lock);
+	dump->queued = dump->current;
+	dump->queued_count = dump->count;
+	SDL_CondBroadcast(dump->changed);
+	SDL_UnlockMutex(dump->lock);
+	dump->current ^= 1;
+	dump->count = 0;
+}
+
+// Opens a frame dump
+FrameDump *framedump_open(const char *path, int every)
+{
+	size_t length = strlen(path);
+	FrameDump *dump = calloc(1, sizeof(FrameDump));
+	if (!dump)
+		return NULL;
+	dump->y4m = length >= 4 && strcmp(path + length - 4, ".y4m") == 0;
+	dump->every = every > 0 ? every : 1;
+	dump->queued = -1;
+	if (!SDL_AtomicGet(&expand_ready))
+		build_expand();
+	dump->file = fopen(path, "wb");
+	dump->batches[0] = malloc((size_t)BATCH_FRAMES * VIDEO_BYTES);
+	dump->batches[1] = malloc((size_t)BATCH_FRAMES * VIDEO_BYTES);
+	dump->lock = SDL_CreateMutex();
+	dump->changed = SDL_CreateCond();
+	if (!dump->file || !dump->batches[0] || !dump->batches[1] || !dump->lock || !dump->changed ||
+		(dump->y4m && fprintf(dump->file, "YUV4MPEG2 W%d H%d F60:1 Ip A1:1 Cmono\n",
+			SCREEN_WIDTH, SCREEN_HEIGHT) < 0) ||
+		!(dump->writer = SDL_CreateThread(writer_main, "framedump", dump)))
+	{
+		fprintf(stderr, "Unable to write frames to %s\n", path);
+		framedump_close(dump);
+		return NULL;
+	}
+	return dump;
+}
+
+// Keeps every Nth frame
+void framedump_frame(FrameDump *dump, const uint8_t *vram)
+{
+	if (dump->offered++ % dump->every != 0)
+		return;
+	memcpy(dump->batches[dump->current] + (size_t)dump->count * VIDEO_BYTES, vram, VIDEO_BYTES);
+	if (++dump->count == BATCH_FRAMES)
+		hand_off(dump);
+}
+
+// Flushes and closes a frame dump
+int framedump_close(FrameDump *dump)
+{
+	int status;
+	if (!dump)
+		return 0;
+	if (dump->writer)
+	{
+		if (dump->count > 0)
+			hand_off(dump);
+		SDL_LockMutex(dump->lock);
+		dump->closing = 1;
+		SDL_CondBroadcast(dump->changed);
+		SDL_UnlockMutex(dump->lock);
+		SDL_WaitThread(dump->writer, NULL);
+	}
+	status = dump->failed || !dump->file ? -1 : 0;
+	if (dump->file && fclose(dump->file) != 0)
+		status = -1;
+	if (dump->changed)
+		SDL_DestroyCond(dump->changed);
+	if (dump->lock)
+		SDL_DestroyMutex(dump->lock);
+	free(dump->batches[0]);
+	free(dump->batches[1]);
+	free(dump);
+	return status;
+}
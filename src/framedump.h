@@ -0,0 +1,61 @@
+/*******************************************************************************
+ * File: framedump.h
+ *
+ * Purpose:
+ *		Specification for dumping frames to a video file.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Writes frames to a file for reviewing runs without a display. A path
+ * ending in .y4m gets a YUV4MPEG2 stream (224x256, 60 fps, greyscale) that
+ * most video tools read directly; anything else gets raw video memory, one
+ * VIDEO_BYTES block of 1bpp pixels per frame in the machine's own rotated
+ * layout.
+ *
+ * Frames are copied into one of two batches while a background thread
+ * converts and writes the other, so the emulator only ever waits when the
+ * disk can't keep up at all.
+ */
+typedef struct FrameDump FrameDump;
+
+/**
+ * Creates or truncates the file at path and starts the writer thread. Every
+ * every-th frame offered is kept, starting with the first.
+ */
+FrameDump *framedump_open(const char *path, int every);
+
+/**
+ * Offers the video memory of a finished frame.
+ */
+void framedump_frame(FrameDump *dump, const uint8_t *vram);
+
+/**
+ * Writes the frames still buffered, stops the writer and closes the file.
+ * Returns 0 if everything was written, -1 otherwise.
+ */
+int framedump_close(FrameDump *dump);
@@ -0,0 +1,100 @@
+/*******************************************************************************
+ * File: framequeue.c
+ *
+ * Purpose:
+ *		Implementation of the triple-buffered queue of video frames.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#include "framequeue.h"
+
+#include <SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Set alongside the middle buffer's index while it holds a frame not yet taken
+#define FRESH 4
+
+typedef struct Frame {
+	uint8_t vram[VIDEO_BYTES];
+	uint32_t dirty;
+	int complete;
+} Frame;
+
+struct FrameQueue {
+	Frame frames[3];
+	SDL_atomic_t middle; // Index of the newest finished frame, plus FRESH
+	int back; // Frame the producer fills
+	int front; // Frame the consumer last took
+	uint32_t unseen; // Strips changed since the last frame known to be taken
+};
+
+// Creates a frame queue
+FrameQueue *framequeue_create(void)
+{
+	FrameQueue *queue = calloc(1, sizeof(FrameQueue));
+	if (!queue)
+		return NULL;
+	queue->back = 0;
+	SDL_AtomicSet(&queue->middle, 1);
+	queue->front = 2;
+	return queue;
+}
+
+// Publishes a frame
+void framequeue_publish(FrameQueue *queue, const uint8_t *vram, uint32_t dirty, int complete)
+{
+	Frame *frame = &queue->frames[queue->back];
+	int previous;
+
+	memcpy(frame->vram, vram, VIDEO_BYTES);
+	frame->dirty = queue->unseen | dirty;
+	frame->complete = complete;
+	previous = SDL_AtomicSet(&queue->middle, queue->back | FRESH);
+	queue->back = previous & ~FRESH;
+	// Getting back a frame that was never taken means the consumer skips
+	// straight to this one, so this frame's mask has to cover both. Either
+	// way this frame may be dropped too, so its changes stay unseen until
+	// the next publish learns otherwise.
+	queue->unseen = (previous & FRESH) ? frame->dirty : dirty;
+}
+
+// Takes the newest frame
+const uint8_t *framequeue_take(FrameQueue *queue, uint32_t *dirty, int *complete)
+{
+	int previous;
+
+	if (!(SDL_AtomicGet(&queue->middle) & FRESH))
+		return NULL;
+	previous = SDL_AtomicSet(&queue->middle, queue->front);
+	queue->front = previous & ~FRESH;
+	*dirty = queue->frames[queue->front].dirty;
+	*complete = queue->frames[queue->front].complete;
+	return queue->frames[queue->front].vram;
+}
+
+// Releases a frame queue
+void framequeue_destroy(FrameQueue *queue)
+{
+	free(queue);
+}
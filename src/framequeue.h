@@ -0,0 +1,71 @@
+/*******************************************************************************
+ * File: framequeue.h
+ *
+ * Purpose:
+ *		Specification for the triple-buffered queue of video frames.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "video.h"
+
+#include <stdint.h>
+
+/*
+ * Hands copies of video memory from the emulation thread to the render thread
+ * without either ever waiting on the other. There are three buffers: the
+ * producer fills one, the consumer reads another and the third holds the
+ * newest finished frame, swapped in and out atomically. A frame the consumer
+ * never got to is dropped, but the strips it changed carry over into the next
+ * one so the renderer still repaints them.
+ *
+ * A frame may be published in parts, e.g. a half at a time as the beam
+ * finishes with it; only the last part is marked complete.
+ */
+typedef struct FrameQueue FrameQueue;
+
+/**
+ * Creates an empty frame queue.
+ */
+FrameQueue *framequeue_create(void);
+
+/**
+ * Publishes a frame of video memory with the mask of strips that changed since
+ * the previous one, and whether it finishes a frame rather than being part of
+ * one. Only one thread may publish.
+ */
+void framequeue_publish(FrameQueue *queue, const uint8_t *vram, uint32_t dirty, int complete);
+
+/**
+ * Takes the newest published frame if there is one the caller hasn't seen,
+ * storing the strips changed since the last frame taken in dirty and whether
+ * it was complete in complete. The frame stays valid until the next call.
+ * Returns NULL if nothing new was published. Only one thread may take.
+ */
+const uint8_t *framequeue_take(FrameQueue *queue, uint32_t *dirty, int *complete);
+
+/**
+ * Releases a frame queue.
+ */
+void framequeue_destroy(FrameQueue *queue);
@@ -0,0 +1,152 @@
+/*******************************************************************************
+ * File: hash.c
+ *
+ * Purpose:
+ *		A fast non-cryptographic hash used to compare emulated memory.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#include "hash.h"
+
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HASH_SSE2
+#include <emmintrin.h>
+#endif
+
+#define HASH_LANES 4
+#define HASH_STRIPE (HASH_LANES * sizeof(uint64_t))
+
+static const uint64_t lane_keys[HASH_LANES] = {
+	0xbe4ba423396cfeb8ull, 0x1cad21f72c81017cull,
+	0xdb979083e96dd4deull, 0x1f67b3b7a4a44072ull,
+};
+
+static uint64_t load64(const uint8_t *p)
+{
+	uint64_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+// Mixes one stripe into the lanes. Each lane adds the product of the two
+// halves of its keyed input plus the input itself, which only needs a
+// 32x32->64 multiply and so maps onto SSE2's pmuludq.
+static void accumulate(uint64_t acc[HASH_LANES], const uint8_t *stripe)
+{
+	for (int lane = 0; lane < HASH_LANES; ++lane)
+	{
+		uint64_t value = load64(stripe + lane * sizeof(uint64_t));
+		uint64_t keyed = value ^ lane_keys[lane];
+		acc[lane] += (keyed & 0xffffffffu) * (keyed >> 32);
+		acc[lane] += value;
+	}
+}
+
+#if defined(__AVX2__)
+
+// All four lanes in one register
+static void accumulate_stripes(uint64_t acc[HASH_LANES], const uint8_t *bytes, size_t stripes)
+{
+	const __m256i keys = _mm256_loadu_si256((const __m256i *)lane_keys);
+	__m256i sum = _mm256_loadu_si256((const __m256i *)acc);
+	for (size_t i = 0; i < stripes; ++i)
+	{
+		__m256i value = _mm256_loadu_si256((const __m256i *)(bytes + i * HASH_STRIPE));
+		__m256i keyed = _mm256_xor_si256(value, keys);
+		sum = _mm256_add_epi64(sum, _mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32)));
+		sum = _mm256_add_epi64(sum, value);
+	}
+	_mm256_storeu_si256((__m256i *)acc, sum);
+}
+
+#elif defined(HASH_SSE2)
+
+// Two lanes per register
+static void accumulate_stripes(uint64_t acc[HASH_LANES], const uint8_t *bytes, size_t stripes)
+{
+	const __m128i keys_low = _mm_loadu_si128((const __m128i *)lane_keys);
+	const __m128i keys_high = _mm_loadu_si128((const __m128i *)(lane_keys + 2));
+	__m128i sum_low = _mm_loadu_si128((const __m128i *)acc);
+	__m128i sum_high = _mm_loadu_si128((const __m128i *)(acc + 2));
+	for (size_t i = 0; i < stripes; ++i)
+	{
+		__m128i low = _mm_loadu_si128((const __m128i *)(bytes + i * HASH_STRIPE));
+		__m128i high = _mm_loadu_si128((const __m128i *)(bytes + i * HASH_STRIPE + 16));
+		__m128i keyed_low = _mm_xor_si128(low, keys_low);
+		__m128i keyed_high = _mm_xor_si128(high, keys_high);
+		sum_low = _mm_add_epi64(sum_low, _mm_mul_epu32(keyed_low, _mm_srli_epi64(keyed_low, 32)));
+		sum_high = _mm_add_epi64(sum_high, _mm_mul_epu32(keyed_high, _mm_srli_epi64(keyed_high, 32)));
+		sum_low = _mm_add_epi64(sum_low, low);
+		sum_high = _mm_add_epi64(sum_high, high);
+	}
+	_mm_storeu_si128((__m128i *)acc, sum_low);
+	_mm_storeu_si128((__m128i *)(acc + 2), sum_high);
+}
+
+#else
+
+static void accumulate_stripes(uint64_t acc[HASH_LANES], const uint8_t *bytes, size_t stripes)
+{
+	for (size_t i = 0; i < stripes; ++i)
+		accumulate(acc, bytes + i * HASH_STRIPE);
+}
+
+#endif
+
+static uint64_t avalanche(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+// Hashes a block of bytes
+uint64_t hash_bytes(const void *data, size_t size)
+{
+	const uint8_t *bytes = data;
+	uint64_t acc[HASH_LANES] = { 0 };
+	uint8_t tail[HASH_STRIPE] = { 0 };
+	size_t stripes = size / HASH_STRIPE;
+	uint64_t h = size * 0x9e3779b185ebca87ull;
+
+	accumulate_stripes(acc, bytes, stripes);
+	if (size % HASH_STRIPE)
+	{
+		memcpy(tail, bytes + stripes * HASH_STRIPE, size % HASH_STRIPE);
+		accumulate(acc, tail);
+	}
+
+	for (int lane = 0; lane < HASH_LANES; ++lane)
+	{
+		h ^= avalanche(acc[lane]);
+		h = ((h << 27) | (h >> 37)) * 0x9e3779b185ebca87ull + 0x85ebca77c2b2ae63ull;
+	}
+	return avalanche(h);
+}
@@ -0,0 +1,158 @@
+/*******************************************************************************
+ * File: hashlog.c
+ *
+ * Purpose:
+ *		Implementation of the per-frame hash log.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#include "hashlog.h"
+
+#include "bytes.h"
+#include "hash.h"
+#include "video.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HEADER_SIZE 16
+#define MAGIC "8080HLOG"
+
+struct HashLog {
+	FILE *file;
+	uint16_t start;
+	uint16_t size;
+	int failed;
+};
+
+// Creates a hash log
+HashLog *hashlog_create(const char *path, int all_ram)
+{
+	uint8_t header[HEADER_SIZE];
+	HashLog *log = calloc(1, sizeof(HashLog));
+	if (!log)
+		return NULL;
+	log->start = all_ram ? HASHLOG_RAM : VIDEO_RAM;
+	log->size = all_ram ? HASHLOG_RAM_SIZE : VIDEO_BYTES;
+	memcpy(header, MAGIC, 8);
+	put_le32(header + 8, log->start);
+	put_le32(header + 12, log->size);
+	log->file = fopen(path, "wb");
+	if (!log->file || fwrite(header, sizeof(header), 1, log->file) != 1)
+	{
+		fprintf(stderr, "Unable to write hash log %s\n", path);
+		if (log->file)
+			fclose(log->file);
+		free(log);
+		return NULL;
+	}
+	return log;
+}
+
+// Appends a frame's hash
+void hashlog_frame(HashLog *log, CPUState *state)
+{
+	uint8_t out[8];
+	put_le64(out, hash_bytes(state->memory + log->start, log->size));
+	if (fwrite(out, sizeof(out), 1, log->file) != 1)
+		log->failed = 1;
+}
+
+// Closes a hash log
+int hashlog_close(HashLog *log)
+{
+	int status;
+	if (!log)
+		return 0;
+	status = log->failed ? -1 : 0;
+	if (fclose(log->file) != 0)
+		status = -1;
+	free(log);
+	return status;
+}
+
+// Opens a hash log for reading and checks its header
+static FILE *open_log(const char *path, uint8_t header[HEADER_SIZE])
+{
+	FILE *f = fopen(path, "rb");
+	if (!f || fread(header, HEADER_SIZE, 1, f) != 1 || memcmp(header, MAGIC, 8) != 0)
+	{
+		fprintf(stderr, "%s is not a hash log\n", path);
+		if (f)
+			fclose(f);
+		return NULL;
+	}
+	return f;
+}
+
+// Finds the first frame two logs disagree on
+int hashlog_diff(const char *path_a, const char *path_b)
+{
+	uint8_t header_a[HEADER_SIZE], header_b[HEADER_SIZE];
+	uint8_t a[8], b[8];
+	unsigned long frame = 0;
+	int status = 0;
+	FILE *fa = open_log(path_a, header_a);
+	FILE *fb = fa ? open_log(path_b, header_b) : NULL;
+	if (!fb)
+	{
+		if (fa)
+			fclose(fa);
+		return -1;
+	}
+	if (memcmp(header_a, header_b, HEADER_SIZE) != 0)
+	{
+		fprintf(stderr, "%s and %s hash different regions of memory\n", path_a, path_b);
+		fclose(fa);
+		fclose(fb);
+		return -1;
+	}
+
+	for (;; ++frame)
+	{
+		int more_a = fread(a, sizeof(a), 1, fa) == 1;
+		int more_b = fread(b, sizeof(b), 1, fb) == 1;
+		if (!more_a && !more_b)
+		{
+			printf("%lu frames match\n", frame);
+			break;
+		}
+		if (more_a != more_b)
+		{
+			printf("%lu frames match, then %s ends\n", frame, more_a ? path_b : path_a);
+			status = 1;
+			break;
+		}
+		if (memcmp(a, b, sizeof(a)) != 0)
+		{
+			printf("First difference at frame %lu: %016llx vs %016llx\n", frame,
+				(unsigned long long)get_le64(a), (unsigned long long)get_le64(b));
+			status = 1;
+			break;
+		}
+	}
+	fclose(fa);
+	fclose(fb);
+	return status;
+}
@@ -0,0 +1,66 @@
+/*******************************************************************************
+ * File: hashlog.h
+ *
+ * Purpose:
+ *		Specification for the per-frame hash log.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "cpu.h"
+
+/*
+ * Records a 64-bit hash of video memory, or of all of RAM, after every frame,
+ * so two runs (a recording and its replay, or two builds of the CPU core) can
+ * be checked frame for frame. The file is a 16-byte header followed by one
+ * little-endian hash per frame.
+ */
+typedef struct HashLog HashLog;
+
+// Start of the 8 KB of RAM, of which video memory is the top 7 KB
+#define HASHLOG_RAM 0x2000
+#define HASHLOG_RAM_SIZE 0x2000
+
+/**
+ * Creates or truncates a hash log at path, hashing all of RAM rather than
+ * just video memory if all_ram is set.
+ */
+HashLog *hashlog_create(const char *path, int all_ram);
+
+/**
+ * Appends the hash of a finished frame.
+ */
+void hashlog_frame(HashLog *log, CPUState *state);
+
+/**
+ * Closes a hash log. Returns 0 if every hash was written, -1 otherwise.
+ */
+int hashlog_close(HashLog *log);
+
+/**
+ * Compares two hash logs and reports the first frame they disagree on, or
+ * that they match. Returns 0 if they match, 1 if they differ and -1 if either
+ * can't be read or they hash different regions.
+ */
+int hashlog_diff(const char *path_a, const char *path_b);
@@ -24,11 +24,77 @@
  ******************************************************************************/
 
 #include "cpu.h"
+#include "debugger.h"
+#include "forkserver.h"
+#include "framedump.h"
+#include "frame.h"
+#include "framequeue.h"
+#include "hashlog.h"
+#include "mosaic.h"
+#include "movie.h"
+#include "overlay.h"
 #include "platform.h"
+#include "rewind.h"
+#include "shmring.h"
+#include "snapshot.h"
+#include "soundqueue.h"
+#include "video.h"
 
 #include <SDL.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+typedef struct Options {
+	const char *rom_directory;
+	int rewind_seconds;
+	int rewind_megabytes;
+	int boot_frames;
+	int headless;
+	int fork_server;
+	long frames; /* Frames to run before exiting, or 0 to run until quit */
+	const char *record_path;
+	const char *play_path;
+	int run_ahead;
+	int debug;
+	int double_buffer;
+	int single_threaded;
+	ScaleFilter filter;
+	int scale;
+	int scale_threads;
+	const char *overlay_path;
+	const char *dump_path;
+	int dump_every;
+	const char *hash_log_path;
+	int hash_ram;
+	const char *hash_diff[2];
+	const char *shm_name;
+	int mosaic;
+	int mosaic_threads;
+	int mosaic_dedup;
+} Options;
+
+/* Everything the windowed loop works on. In the threaded pipeline the
+ * emulation thread holds lock while it runs a frame, and the render thread
+ * takes it only to poll input, which writes the machine's ports and can load
+ * a save state. */
+typedef struct Session {
+	CPUState *state;
+	Platform *platform;
+	RewindBuffer *rewind;
+	GoldenSnapshot *golden;
+	GoldenSnapshot *save_point;
+	Movie *movie;
+	ShmRing *shm;
+	const Options *options;
+	long frames;
+	FrameQueue *queue; /* Where finished frames go, or NULL to draw them in line */
+	uint32_t video_mark;
+	uint32_t unshown; /* Strips written but not yet shown */
+	uint8_t vram[VIDEO_BYTES]; /* Each half of video memory as the beam last drew it */
+	SDL_mutex *lock;
+	SDL_atomic_t quit;
+} Session;
 
 static void load_roms(CPUState *state, const char *directory)
 {
@@ -40,43 +106,522 @@ static void load_roms(CPUState *state, const char *directory)
 	}
 }
 
+static void run_frame(CPUState *state)
+{
+	for (int instruction = 0; instruction < FRAME_INSTRUCTIONS && state->running; ++instruction)
+		frame_step(state, instruction);
+}
+
+static int parse_options(int argc, char **argv, Options *options)
+{
+	options->rom_directory = "../rom";
+	options->rewind_seconds = 10;
+	options->rewind_megabytes = 8;
+	options->boot_frames = 120;
+	options->headless = 0;
+	options->fork_server = 0;
+	options->frames = 0;
+	options->record_path = NULL;
+	options->play_path = NULL;
+	options->run_ahead = 0;
+	options->debug = 0;
+	options->double_buffer = 0;
+	options->single_threaded = 0;
+	options->filter = SCALE_NONE;
+	options->scale = 3;
+	options->scale_threads = 1;
+	options->overlay_path = NULL;
+	options->dump_path = NULL;
+	options->dump_every = 1;
+	options->hash_log_path = NULL;
+	options->hash_ram = 0;
+	options->hash_diff[0] = options->hash_diff[1] = NULL;
+	options->shm_name = NULL;
+	options->mosaic = 0;
+	options->mosaic_threads = 0;
+	options->mosaic_dedup = 0;
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--rewind-seconds") == 0 && i + 1 < argc)
+			options->rewind_seconds = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--rewind-mb") == 0 && i + 1 < argc)
+			options->rewind_megabytes = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--boot-frames") == 0 && i + 1 < argc)
+			options->boot_frames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--headless") == 0)
+			options->headless = 1;
+		else if (strcmp(argv[i], "--fork-server") == 0)
+			options->fork_server = options->headless = 1;
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			options->frames = atol(argv[++i]);
+		else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+			options->record_path = argv[++i];
+		else if (strcmp(argv[i], "--debug") == 0)
+			options->debug = options->headless = 1;
+		else if (strcmp(argv[i], "--double-buffer") == 0)
+			options->double_buffer = 1;
+		else if (strcmp(argv[i], "--single-threaded") == 0)
+			options->single_threaded = 1;
+		else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc && scale_parse_filter(argv[i + 1]) >= 0)
+			options->filter = (ScaleFilter)scale_parse_filter(argv[++i]);
+		else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc)
+			options->scale = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--scale-threads") == 0 && i + 1 < argc)
+			options->scale_threads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--overlay") == 0 && i + 1 < argc)
+			options->overlay_path = argv[++i];
+		else if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+			options->dump_path = argv[++i];
+			options->headless = 1;
+		}
+		else if (strcmp(argv[i], "--dump-every") == 0 && i + 1 < argc)
+			options->dump_every = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--hash-log") == 0 && i + 1 < argc) {
+			options->hash_log_path = argv[++i];
+			options->headless = 1;
+		}
+		else if (strcmp(argv[i], "--hash-ram") == 0)
+			options->hash_ram = 1;
+		else if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc)
+			options->shm_name = argv[++i];
+		else if (strcmp(argv[i], "--mosaic") == 0 && i + 1 < argc)
+			options->mosaic = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--mosaic-threads") == 0 && i + 1 < argc)
+			options->mosaic_threads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--mosaic-dedup") == 0)
+			options->mosaic_dedup = 1;
+		else if (strcmp(argv[i], "--hash-diff") == 0 && i + 2 < argc) {
+			options->hash_diff[0] = argv[++i];
+			options->hash_diff[1] = argv[++i];
+		}
+		else if (strcmp(argv[i], "--run-ahead") == 0 && i + 1 < argc)
+			options->run_ahead = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--play") == 0 && i + 1 < argc) {
+			options->play_path = argv[++i];
+			options->headless = 1;
+		}
+		else if (argv[i][0] == '-') {
+			fprintf(stderr, "usage: %s [--rewind-seconds N] [--rewind-mb N] [--boot-frames N]\n"
+				"       [--headless] [--fork-server] [--frames N] [--record FILE] [--play FILE]\n"
+				"       [--run-ahead N] [--debug] [--double-buffer] [--single-threaded]\n"
+				"       [--filter none|nearest|scale2x|scale3x|scanlines] [--scale N]\n"
+				"       [--scale-threads N] [--overlay FILE] [--dump FILE] [--dump-every N]\n"
+				"       [--hash-log FILE] [--hash-ram] [--shm NAME] [--mosaic N]\n"
+				"       [--mosaic-threads N] [--mosaic-dedup] [rom directory]\n"
+				"       %s --hash-diff LOG LOG\n", argv[0], argv[0]);
+			return 0;
+		}
+		else
+			options->rom_directory = argv[i];
+	}
+	/* Recordings start at power-on, but fork-server children start after
+	 * the boot frames, so a replay could never match. */
+	if (options->fork_server && options->play_path) {
+		fprintf(stderr, "--play can't be combined with --fork-server\n");
+		return 0;
+	}
+	/* The debugger steps the machine itself, so no frame would reach them. */
+	if (options->debug && (options->dump_path || options->hash_log_path || options->shm_name)) {
+		fprintf(stderr, "--dump, --hash-log and --shm can't be combined with --debug\n");
+		return 0;
+	}
+	return 1;
+}
+
+/* Boots the machine once and shows a grid of copies of it running side by
+ * side, each on its own random input. */
+static int run_mosaic(CPUState *state, const Options *options)
+{
+	Mosaic *mosaic;
+	int status;
+	for (int frame = 0; frame < options->boot_frames && state->running; ++frame)
+		run_frame(state);
+	mosaic = mosaic_create(state, options->mosaic, options->mosaic_threads);
+	if (!mosaic) {
+		fprintf(stderr, "Unable to allocate %d instances\n", options->mosaic);
+		return EXIT_FAILURE;
+	}
+	if (options->mosaic_dedup) {
+		DedupStats stats;
+		if (mosaic_dedup(mosaic, &stats) != 0)
+			fprintf(stderr, "Pages could only partly be shared, if at all\n");
+		printf("Shared %zu of %zu pages onto %zu frames, saving %zu KB\n", stats.pages_shared,
+			stats.pages_scanned, stats.frames_used, stats.bytes_saved / 1024);
+	}
+	status = mosaic_view(mosaic, options->frames) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	mosaic_destroy(mosaic);
+	return status;
+}
+
+/* Runs without a window or frame pacing until the frame limit, the end of
+ * the movie being played or the CPU stops, or hands the machine to the
+ * debugger console. The fork server forks from here once the boot frames are
+ * done. */
+static int run_headless(CPUState *state, const Options *options)
+{
+	Movie *movie = NULL;
+	FrameDump *dump = NULL;
+	HashLog *hash_log = NULL;
+	ShmRing *shm = NULL;
+	long frames = 0;
+	int status = EXIT_SUCCESS;
+	uint64_t start;
+
+	if (options->fork_server) {
+		int served;
+		for (int frame = 0; frame < options->boot_frames && state->running; ++frame)
+			run_frame(state);
+		served = forkserver_run();
+		if (served < 0)
+			return EXIT_FAILURE;
+		if (served == 2)
+			return EXIT_SUCCESS;
+	}
+	if (options->play_path && !(movie = movie_play(options->play_path, state)))
+		return EXIT_FAILURE;
+	if (options->debug) {
+		Debugger *debugger = debugger_create(state, movie);
+		if (!debugger) {
+			fprintf(stderr, "Unable to start the debugger\n");
+			status = EXIT_FAILURE;
+		} else {
+			debugger_console(debugger, stdin);
+			debugger_destroy(debugger);
+		}
+		movie_destroy(movie);
+		return status;
+	}
+
+	if ((options->dump_path && !(dump = framedump_open(options->dump_path, options->dump_every))) ||
+		(options->hash_log_path && !(hash_log = hashlog_create(options->hash_log_path, options->hash_ram))) ||
+		(options->shm_name && !(shm = shmring_create(options->shm_name)))) {
+		framedump_close(dump);
+		hashlog_close(hash_log);
+		movie_destroy(movie);
+		return EXIT_FAILURE;
+	}
+
+	start = SDL_GetPerformanceCounter();
+	for (; state->running && (options->frames <= 0 || frames < options->frames); ++frames) {
+		if (movie) {
+			if (movie_finished(movie))
+				break;
+			movie_begin_frame(movie, state);
+		}
+		run_frame(state);
+		if (dump)
+			framedump_frame(dump, state->memory + VIDEO_RAM);
+		if (hash_log)
+			hashlog_frame(hash_log, state);
+		if (shm)
+			shmring_publish(shm, state->memory + VIDEO_RAM);
+		if (movie && !movie_end_frame(movie, state)) {
+			fprintf(stderr, "Replay diverged from the recording at frame %u\n", movie_frame(movie) - 1);
+			status = EXIT_FAILURE;
+			break;
+		}
+	}
+	if (movie && status == EXIT_SUCCESS) {
+		double seconds = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+		printf("Replayed %u frames in %.3f s (%.0f frames/s)\n", movie_frame(movie), seconds,
+			seconds > 0 ? movie_frame(movie) / seconds : 0.0);
+	}
+	if (framedump_close(dump) != 0) {
+		fprintf(stderr, "Unable to write every frame to %s\n", options->dump_path);
+		status = EXIT_FAILURE;
+	}
+	if (hashlog_close(hash_log) != 0) {
+		fprintf(stderr, "Unable to write every hash to %s\n", options->hash_log_path);
+		status = EXIT_FAILURE;
+	}
+	shmring_destroy(shm);
+	movie_destroy(movie);
+	return status;
+}
+
+/* Shows the half of the screen the beam has just finished, at the interrupt
+ * that ends it: the render thread converts the first half while the second is
+ * being emulated. Sampling each half as it was when the beam drew it, rather
+ * than all of it after the frame, is what keeps sprites the game moves behind
+ * the beam from tearing. */
+static void show_half(Session *session, int second)
+{
+	CPUState *state = session->state;
+	uint32_t strips = second ? VIDEO_SECOND_HALF : VIDEO_FIRST_HALF;
+	uint32_t dirty;
+	session->unshown |= video_dirty_strips(state, &session->video_mark);
+	dirty = session->unshown & strips;
+	session->unshown &= ~strips;
+	if (session->queue) {
+		size_t offset = second ? VIDEO_BYTES / 2 : 0;
+		memcpy(session->vram + offset, state->memory + VIDEO_RAM + offset, VIDEO_BYTES / 2);
+		framequeue_publish(session->queue, session->vram, dirty, second);
+	} else {
+		platform_draw_vram(session->platform, state->memory + VIDEO_RAM, dirty, strips);
+		if (second)
+			platform_present(session->platform);
+	}
+}
+
+/* Runs a frame that is going to be shown, showing each half as it finishes. */
+static void run_shown_frame(Session *session)
+{
+	CPUState *state = session->state;
+	int instruction = 0;
+	for (; instruction < FRAME_MID_INSTRUCTIONS && state->running; ++instruction)
+		frame_step(state, instruction);
+	show_half(session, 0);
+	for (; instruction < FRAME_INSTRUCTIONS && state->running; ++instruction)
+		frame_step(state, instruction);
+	show_half(session, 1);
+}
+
+/* Whether the machine should run another frame. */
+static int session_running(Session *session)
+{
+	return session->state->running &&
+		(session->options->frames <= 0 || session->frames < session->options->frames);
+}
+
+/* Runs, rewinds or resets one frame of the machine according to the input
+ * last polled, and shows it. */
+static void session_frame(Session *session)
+{
+	CPUState *state = session->state;
+	const Options *options = session->options;
+	int rewinding = session->rewind && platform_rewinding(session->platform);
+	int shown = 0;
+	if (session->golden && platform_take_reset(session->platform)) {
+		golden_restore(session->golden, state);
+	} else if (rewinding) {
+		rewind_step(session->rewind, state);
+	} else {
+		if (session->movie)
+			movie_begin_frame(session->movie, state);
+		/* Only this frame is really played, so only its OUTs make sound;
+		 * rewinding, resets and run-ahead frames stay silent. */
+		state->sound_events = platform_sound_events(session->platform);
+		/* A reset, rewind or state load may have left the ports other than
+		 * the audio last heard, e.g. with the UFO still droning. */
+		if (state->sound_events) {
+			soundqueue_push(state->sound_events, 0, 3, state->output_ports[3]);
+			soundqueue_push(state->sound_events, 0, 5, state->output_ports[5]);
+		}
+		if (session->save_point) {
+			run_frame(state);
+		} else {
+			run_shown_frame(session);
+			shown = 1;
+		}
+		if (state->sound_events)
+			soundqueue_end_frame(state->sound_events);
+		state->sound_events = NULL;
+		if (session->movie)
+			movie_end_frame(session->movie, state);
+		/* Capture the machine once it has booted so resets skip ROM
+		 * loading and the RAM test. */
+		if (++session->frames == options->boot_frames && !session->movie)
+			session->golden = golden_capture(state);
+		if (session->rewind)
+			rewind_capture(session->rewind, state);
+	}
+	/* The ring gets the frame the machine really reached, never the
+	 * run-ahead one shown below and rolled back. */
+	if (session->shm)
+		shmring_publish(session->shm, state->memory + VIDEO_RAM);
+	if (session->save_point && !rewinding) {
+		/* Show where the current input leads a few frames on, then put
+		 * the machine back; only the pages those frames wrote are
+		 * copied either way. */
+		golden_refresh(session->save_point, state);
+		for (int ahead = 1; ahead < options->run_ahead; ++ahead)
+			run_frame(state);
+		run_shown_frame(session);
+		golden_restore(session->save_point, state);
+	} else if (!shown) {
+		show_half(session, 0);
+		show_half(session, 1);
+	}
+}
+
+/* Sleeps out the rest of a 60 Hz frame that began at start. */
+static void pace_frame(uint64_t start)
+{
+	uint64_t elapsed = SDL_GetPerformanceCounter() - start;
+	uint64_t frame = SDL_GetPerformanceFrequency() / 60;
+	if (elapsed < frame)
+		SDL_Delay((uint32_t)((frame - elapsed) * 1000 / SDL_GetPerformanceFrequency()));
+}
+
+/* Emulates at 60 Hz on its own thread, so a slow present or a vsync wait on
+ * the render thread never delays a frame. */
+static int emulation_thread(void *data)
+{
+	Session *session = data;
+	while (!SDL_AtomicGet(&session->quit)) {
+		uint64_t frame_start = SDL_GetPerformanceCounter();
+		int running;
+		SDL_LockMutex(session->lock);
+		running = session_running(session);
+		if (running)
+			session_frame(session);
+		SDL_UnlockMutex(session->lock);
+		if (!running)
+			break;
+		pace_frame(frame_start);
+	}
+	SDL_AtomicSet(&session->quit, 1);
+	return 0;
+}
+
+/* Converts and presents frames as the emulation thread publishes them,
+ * polling input once per frame, until either side quits. */
+static int run_threaded(Session *session)
+{
+	SDL_Thread *thread;
+	session->queue = framequeue_create();
+	session->lock = SDL_CreateMutex();
+	SDL_AtomicSet(&session->quit, 0);
+	thread = session->queue && session->lock ?
+		SDL_CreateThread(emulation_thread, "emulation", session) : NULL;
+	if (!thread) {
+		/* Fall back to drawing in line. */
+		framequeue_destroy(session->queue);
+		session->queue = NULL;
+		return 0;
+	}
+	while (!SDL_AtomicGet(&session->quit)) {
+		uint32_t dirty;
+		int complete;
+		const uint8_t *vram = framequeue_take(session->queue, &dirty, &complete);
+		if (!vram) {
+			SDL_Delay(1);
+			continue;
+		}
+		/* The frame queue holds each half as the beam drew it, so every
+		 * strip in it is safe to convert. */
+		platform_draw_vram(session->platform, vram, dirty, VIDEO_ALL_STRIPS);
+		if (complete) {
+			int polled;
+			SDL_LockMutex(session->lock);
+			polled = platform_poll(session->platform, session->state);
+			SDL_UnlockMutex(session->lock);
+			if (!polled)
+				break;
+			platform_present(session->platform);
+		}
+	}
+	SDL_AtomicSet(&session->quit, 1);
+	SDL_WaitThread(thread, NULL);
+	return 1;
+}
+
+/* Emulates and draws each frame in turn on one thread. */
+static void run_serial(Session *session)
+{
+	while (session_running(session)) {
+		uint64_t frame_start = SDL_GetPerformanceCounter();
+		/* Poll right before emulating so input reaches the very next frame. */
+		if (!platform_poll(session->platform, session->state))
+			break;
+		session_frame(session);
+		pace_frame(frame_start);
+	}
+}
+
 int main(int argc, char **argv)
 {
-	CPUState *state = InitCPUState();
+	CPUState *state;
 	Platform *platform;
-	/* Toggle to RST 1 at mid-frame, then RST 2 at vertical blank. */
-	int interrupt = 2;
+	RewindBuffer *rewind = NULL;
+	GoldenSnapshot *save_point = NULL;
+	Movie *movie = NULL;
+	Options options;
+	Session session;
 
-	load_roms(state, argc > 1 ? argv[1] : "../rom");
-	platform = platform_create();
+	if (!parse_options(argc, argv, &options))
+		return EXIT_FAILURE;
+	if (options.hash_diff[0])
+		return hashlog_diff(options.hash_diff[0], options.hash_diff[1]) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	state = InitCPUStateWithLayout(CPU_LAYOUT_INLINE);
+	if (!state) {
+		fprintf(stderr, "Unable to allocate the emulated machine\n");
+		return EXIT_FAILURE;
+	}
+	load_roms(state, options.rom_directory);
+	if (options.mosaic > 0) {
+		int status = run_mosaic(state, &options);
+		FreeCPUState(state);
+		return status;
+	}
+	if (options.headless) {
+		int status = run_headless(state, &options);
+		FreeCPUState(state);
+		return status;
+	}
+	if (options.overlay_path) {
+		static VideoOverlay overlay;
+		if (overlay_load(options.overlay_path, &overlay) != 0) {
+			FreeCPUState(state);
+			return EXIT_FAILURE;
+		}
+		video_set_overlay(&overlay);
+	}
+	/* A recording has to be one unbroken run from power-on, so it rules out
+	 * rewinding, resets and loading. */
+	if (options.record_path && !(movie = movie_record(state))) {
+		fprintf(stderr, "Unable to start recording\n");
+		FreeCPUState(state);
+		return EXIT_FAILURE;
+	}
+	if (options.rewind_seconds > 0 && !movie) {
+		/* A keyframe every second bounds how far a restore has to replay. */
+		rewind = rewind_create((size_t)options.rewind_megabytes * 1024 * 1024,
+			options.rewind_seconds * 60, 60);
+		if (!rewind)
+			fprintf(stderr, "Rewind disabled: %d MB can't hold two keyframes\n", options.rewind_megabytes);
+	}
+	platform = platform_create(options.double_buffer, options.filter, options.scale, options.scale_threads);
 	if (!platform) {
 		fprintf(stderr, "Unable to initialize SDL: %s\n", SDL_GetError());
+		movie_destroy(movie);
+		rewind_destroy(rewind);
+		FreeCPUState(state);
 		return EXIT_FAILURE;
 	}
+	if (movie)
+		platform_disable_loads(platform);
+	if (options.run_ahead > 0)
+		save_point = golden_capture(state);
 
-	while (state->running) {
-		uint64_t frame_start = SDL_GetPerformanceCounter();
-		/* About 2 MHz at the 8080's typical instruction length. */
-		for (int instruction = 0; instruction < 7000 && state->running; ++instruction) {
-			runCPUCycle(state);
-			if (instruction == 3499 || instruction == 6999) {
-				if (state->int_enable) {
-					interrupt = (interrupt == 1) ? 2 : 1;
-					raiseInterrupt(state, interrupt);
-				}
-			}
-		}
-		state->running = (uint8_t)platform_update(platform, state);
-		{
-			uint64_t elapsed = SDL_GetPerformanceCounter() - frame_start;
-			uint64_t frame = SDL_GetPerformanceFrequency() / 60;
-			if (elapsed < frame)
-				SDL_Delay((uint32_t)((frame - elapsed) * 1000 / SDL_GetPerformanceFrequency()));
-		}
+	memset(&session, 0, sizeof(session));
+	if (options.shm_name && !(session.shm = shmring_create(options.shm_name))) {
+		movie_destroy(movie);
+		platform_destroy(platform);
+		rewind_destroy(rewind);
+		golden_destroy(save_point);
+		FreeCPUState(state);
+		return EXIT_FAILURE;
 	}
+	session.state = state;
+	session.platform = platform;
+	session.rewind = rewind;
+	session.save_point = save_point;
+	session.movie = movie;
+	session.options = &options;
+	if (options.single_threaded || !run_threaded(&session))
+		run_serial(&session);
 
+	if (movie && movie_save(movie, options.record_path) != 0)
+		fprintf(stderr, "Unable to write %s\n", options.record_path);
+	movie_destroy(movie);
 	platform_destroy(platform);
-	free(state->memory);
-	free(state);
+	rewind_destroy(rewind);
+	golden_destroy(session.golden);
+	golden_destroy(save_point);
+	framequeue_destroy(session.queue);
+	shmring_destroy(session.shm);
+	if (session.lock)
+		SDL_DestroyMutex(session.lock);
+	FreeCPUState(state);
 	return EXIT_SUCCESS;
 }
@@ -0,0 +1,146 @@
+/*******************************************************************************
+ * File: memory.c
+ *
+ * Purpose:
+ *		Host memory management for the emulated address space.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#include "memory.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <string.h>
+
+#define HUGE_PAGE_SIZE (2u * 1024 * 1024)
+#define PAGE_SIZE 4096
+
+static size_t block_size(size_t size, int huge)
+{
+	size_t granule = huge ? HUGE_PAGE_SIZE : PAGE_SIZE;
+	return (size + granule - 1) & ~(granule - 1);
+}
+
+// Zeroes the pages of a region that aren't already clear
+void memory_clear(uint8_t *memory, size_t size)
+{
+	for (size_t page = 0; page < size; page += PAGE_SIZE)
+	{
+		const uint64_t *words = (const uint64_t *)(memory + page);
+		size_t length = size - page < PAGE_SIZE ? size - page : PAGE_SIZE;
+		uint64_t bits = 0;
+		for (size_t i = 0; i < length / sizeof(uint64_t); ++i)
+			bits |= words[i];
+		if (bits)
+			memset(memory + page, 0, length);
+	}
+}
+
+#ifdef _WIN32
+
+// Maps a zeroed block. Large pages need a privilege most accounts lack, so
+// Windows always uses normal pages.
+void *memory_map_block(size_t size, int huge)
+{
+	return VirtualAlloc(NULL, block_size(size, huge), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+// Releases a mapped block
+void memory_unmap_block(void *block, size_t size, int huge)
+{
+	(void)size;
+	(void)huge;
+	if (block)
+		VirtualFree(block, 0, MEM_RELEASE);
+}
+
+// NUMA placement is left to the first-touch policy on Windows
+void memory_bind_node(void *block, size_t size, int huge, int node)
+{
+	(void)block;
+	(void)size;
+	(void)huge;
+	(void)node;
+}
+
+#else
+
+// Maps a zeroed block, preferring huge pages when asked for them
+void *memory_map_block(size_t size, int huge)
+{
+	size_t length = block_size(size, huge);
+	void *block = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+	if (huge)
+		block = mmap(NULL, length, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+	if (block == MAP_FAILED)
+	{
+		block = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (block == MAP_FAILED)
+			return NULL;
+#ifdef MADV_HUGEPAGE
+		if (huge)
+			madvise(block, length, MADV_HUGEPAGE);
+#endif
+	}
+	return block;
+}
+
+// Releases a mapped block
+void memory_unmap_block(void *block, size_t size, int huge)
+{
+	if (block)
+		munmap(block, block_size(size, huge));
+}
+
+// Prefers a NUMA node for the block's pages
+void memory_bind_node(void *block, size_t size, int huge, int node)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+	// MPOL_PREFERRED, spelled out so libnuma's headers aren't required
+	unsigned long mask;
+	if (!block || node < 0 || node >= (int)(sizeof(mask) * 8))
+		return;
+	mask = 1ul << node;
+	syscall(SYS_mbind, block, block_size(size, huge), 1, &mask, sizeof(mask) * 8 + 1, 0);
+#else
+	(void)block;
+	(void)size;
+	(void)huge;
+	(void)node;
+#endif
+}
+
+#endif
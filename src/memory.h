@@ -0,0 +1,78 @@
+/*******************************************************************************
+ * File: memory.h
+ *
+ * Purpose:
+ *		Host memory management for the emulated address space.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Size of the 8080's address space
+#define MEMORY_SIZE 0x10000
+
+// Writes are tracked in pages of this size so that snapshots and the renderer
+// can find what changed without scanning the whole address space.
+#define MEMORY_PAGE_SHIFT 8
+#define MEMORY_PAGE_SIZE (1 << MEMORY_PAGE_SHIFT)
+#define MEMORY_PAGES (MEMORY_SIZE >> MEMORY_PAGE_SHIFT)
+
+// The address space is backed by host pages of this size. A page can be
+// private to one CPU state or a copy-on-write view of a shared frame.
+#define MEMORY_FRAME_SIZE 0x1000
+#define MEMORY_FRAMES (MEMORY_SIZE / MEMORY_FRAME_SIZE)
+
+// Granularity used when laying out state that is touched together
+#define CACHE_LINE_SIZE 64
+
+/**
+ * Maps a zeroed, page-aligned block of host memory.
+ *
+ * When huge is non-zero the block is rounded up to a whole huge page and
+ * backed by one if the host can provide it. Otherwise the same rounded size is
+ * mapped with normal pages and the kernel is asked to promote it later, so
+ * memory_unmap_block() never has to know which of the two happened.
+ */
+void *memory_map_block(size_t size, int huge);
+
+/**
+ * Releases a block returned by memory_map_block(). The size and huge arguments
+ * must match the ones the block was mapped with.
+ */
+void memory_unmap_block(void *block, size_t size, int huge);
+
+/**
+ * Zeroes a page-aligned region, skipping pages that are already clear. Pages
+ * the guest never wrote stay untouched, so clearing an address space doesn't
+ * fault in memory it never used.
+ */
+void memory_clear(uint8_t *memory, size_t size);
+
+/**
+ * Asks the host to place the not yet touched pages of a mapped block on the
+ * given NUMA node. Hosts without NUMA support ignore the request.
+ */
+void memory_bind_node(void *block, size_t size, int huge, int node);
@@ -0,0 +1,390 @@
+/*******************************************************************************
+ * File: mosaic.c
+ *
+ * Purpose:
+ *		Runs a farm of emulator instances and shows them as a grid in one window.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#include "mosaic.h"
+
+#include "arena.h"
+#include "frame.h"
+#include "framequeue.h"
+#include "snapshot.h"
+#include "video.h"
+
+#include <SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Player one's coin, start, fire, left and right bits on input port 1
+#define CONTROLS 0x75
+
+// Largest window opened by default; the grid is scaled down to fit
+#define MAX_WINDOW_WIDTH 1536
+#define MAX_WINDOW_HEIGHT 960
+
+typedef struct Instance {
+	CPUState *state;
+	FrameQueue *queue;
+	uint32_t video_mark;
+	uint32_t seed; // Drives the instance's input
+	int hold; // Frames left before the input changes
+	uint8_t shown[VIDEO_BYTES]; // Video memory as the viewer last drew it
+} Instance;
+
+typedef struct Worker {
+	Mosaic *mosaic;
+	CPUArena *arena;
+	Instance *first;
+	int count;
+	SDL_Thread *thread;
+} Worker;
+
+struct Mosaic {
+	Instance *instances;
+	int instance_count;
+	Worker *workers;
+	int worker_count;
+	PagePool *pages; // Frames shared by mosaic_dedup(), or NULL
+	SDL_atomic_t quit;
+};
+
+// Picks new controls for an instance every few frames
+static void steer(Instance *instance)
+{
+	uint32_t x = instance->seed;
+	uint8_t controls;
+	if (--instance->hold > 0)
+		return;
+	// xorshift32
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	instance->seed = x;
+	instance->hold = 4 + (int)(x >> 28);
+	controls = (uint8_t)(x & 0x70);
+	// Now and then insert a coin and press start, so a game that ended
+	// starts over rather than sitting in attract mode.
+	if ((x >> 8 & 15) == 0)
+		controls |= 0x05;
+	instance->state->input_ports[1] = (uint8_t)((instance->state->input_ports[1] & ~CONTROLS) | controls);
+}
+
+// Runs a worker's instances at 60 Hz until told to quit
+static int worker_thread(void *data)
+{
+	Worker *worker = data;
+	uint64_t period = SDL_GetPerformanceFrequency() / 60;
+	uint64_t deadline = SDL_GetPerformanceCounter();
+	while (!SDL_AtomicGet(&worker->mosaic->quit))
+	{
+		uint64_t now;
+		for (int i = 0; i < worker->count; ++i)
+		{
+			Instance *instance = &worker->first[i];
+			CPUState *state = instance->state;
+			if (!state->running)
+				continue;
+			steer(instance);
+			for (int instruction = 0; instruction < FRAME_INSTRUCTIONS && state->running; ++instruction)
+				frame_step(state, instruction);
+			framequeue_publish(instance->queue, state->memory + VIDEO_RAM,
+				video_dirty_strips(state, &instance->video_mark), 1);
+		}
+		// Keep to an absolute schedule so short sleeps don't add up, but
+		// don't try to catch up on frames that were missed altogether.
+		deadline += period;
+		now = SDL_GetPerformanceCounter();
+		if (now < deadline)
+			SDL_Delay((uint32_t)((deadline - now) * 1000 / SDL_GetPerformanceFrequency()));
+		else
+			deadline = now;
+	}
+	return 0;
+}
+
+// Creates the instances
+Mosaic *mosaic_create(CPUState *booted, int instances, int threads)
+{
+	Mosaic *mosaic;
+	GoldenSnapshot *golden;
+	int next = 0, failed = 0;
+	if (instances <= 0)
+		return NULL;
+	if (threads <= 0)
+		threads = SDL_GetCPUCount();
+	if (threads > instances)
+		threads = instances;
+	mosaic = calloc(1, sizeof(Mosaic));
+	golden = golden_capture(booted);
+	if (!mosaic || !golden)
+	{
+		free(mosaic);
+		golden_destroy(golden);
+		return NULL;
+	}
+	mosaic->instances = calloc((size_t)instances, sizeof(Instance));
+	mosaic->workers = calloc((size_t)threads, sizeof(Worker));
+	if (!mosaic->instances || !mosaic->workers)
+	{
+		golden_destroy(golden);
+		mosaic_destroy(mosaic);
+		return NULL;
+	}
+	mosaic->worker_count = threads;
+	for (int w = 0; w < threads; ++w)
+	{
+		Worker *worker = &mosaic->workers[w];
+		worker->mosaic = mosaic;
+		worker->first = &mosaic->instances[next];
+		worker->count = instances / threads + (w < instances % threads);
+		// Each worker's instances share one arena, which only its thread
+		// touches once the mosaic is running.
+		worker->arena = arena_create((size_t)worker->count, 0, -1);
+		for (int i = 0; i < worker->count && worker->arena; ++i, ++next)
+		{
+			Instance *instance = &mosaic->instances[next];
+			instance->state = arena_acquire(worker->arena);
+			instance->queue = framequeue_create();
+			mosaic->instance_count = next + 1;
+			if (!instance->state || !instance->queue)
+			{
+				failed = 1;
+				break;
+			}
+			golden_restore(golden, instance->state);
+			instance->seed = 0x9e3779b9u * (uint32_t)(next + 1);
+		}
+		if (failed || !worker->arena)
+			break;
+	}
+	golden_destroy(golden);
+	if (failed || mosaic->instance_count != instances)
+	{
+		mosaic_destroy(mosaic);
+		return NULL;
+	}
+	return mosaic;
+}
+
+// Shares identical pages between the instances
+int mosaic_dedup(Mosaic *mosaic, DedupStats *stats)
+{
+	CPUState **states;
+	int result;
+	memset(stats, 0, sizeof(*stats));
+	if (!mosaic->pages && !(mosaic->pages = pagepool_create()))
+		return -1;
+	states = malloc((size_t)mosaic->instance_count * sizeof(CPUState *));
+	if (!states)
+		return -1;
+	for (int i = 0; i < mosaic->instance_count; ++i)
+		states[i] = mosaic->instances[i].state;
+	result = pagepool_dedup(mosaic->pages, states, (size_t)mosaic->instance_count, stats);
+	free(states);
+	return result;
+}
+
+// Finds the next run of strips set in mask from *strip on
+static int next_run(uint32_t mask, int *strip)
+{
+	int first;
+	while (*strip < VIDEO_STRIPS && !(mask >> *strip & 1))
+		++*strip;
+	first = *strip;
+	while (*strip < VIDEO_STRIPS && (mask >> *strip & 1))
+		++*strip;
+	return *strip - first;
+}
+
+// Sleeps out the rest of a 60 Hz frame that began at start
+static void pace(uint64_t start)
+{
+	uint64_t elapsed = SDL_GetPerformanceCounter() - start;
+	uint64_t frame = SDL_GetPerformanceFrequency() / 60;
+	if (elapsed < frame)
+		SDL_Delay((uint32_t)((frame - elapsed) * 1000 / SDL_GetPerformanceFrequency()));
+}
+
+// Starts every worker thread
+static int start_workers(Mosaic *mosaic)
+{
+	SDL_AtomicSet(&mosaic->quit, 0);
+	for (int w = 0; w < mosaic->worker_count; ++w)
+	{
+		Worker *worker = &mosaic->workers[w];
+		worker->thread = SDL_CreateThread(worker_thread, "mosaic", worker);
+		if (!worker->thread)
+			return 0;
+	}
+	return 1;
+}
+
+// Stops every worker thread that was started
+static void stop_workers(Mosaic *mosaic)
+{
+	SDL_AtomicSet(&mosaic->quit, 1);
+	for (int w = 0; w < mosaic->worker_count; ++w)
+	{
+		if (mosaic->workers[w].thread)
+			SDL_WaitThread(mosaic->workers[w].thread, NULL);
+		mosaic->workers[w].thread = NULL;
+	}
+}
+
+// Shows the grid
+int mosaic_view(Mosaic *mosaic, long frames)
+{
+	int columns = 1;
+	int rows, width, height, pitch;
+	double zoom = 3.0;
+	SDL_Window *window = NULL;
+	SDL_Renderer *renderer = NULL;
+	SDL_Texture *atlas = NULL;
+	uint32_t *pixels;
+	int present_needed = 1;
+	int status = 0;
+
+	// As square a grid as will hold every instance
+	while (columns * columns < mosaic->instance_count)
+		++columns;
+	rows = (mosaic->instance_count + columns - 1) / columns;
+	width = columns * SCREEN_WIDTH;
+	height = rows * SCREEN_HEIGHT;
+	pitch = width * (int)sizeof(uint32_t);
+	pixels = malloc((size_t)width * height * sizeof(uint32_t));
+	if (zoom > (double)MAX_WINDOW_WIDTH / width)
+		zoom = (double)MAX_WINDOW_WIDTH / width;
+	if (zoom > (double)MAX_WINDOW_HEIGHT / height)
+		zoom = (double)MAX_WINDOW_HEIGHT / height;
+	if (pixels && SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS) == 0)
+	{
+		window = SDL_CreateWindow("Intel 8080 - Space Invaders", SDL_WINDOWPOS_CENTERED,
+			SDL_WINDOWPOS_CENTERED, (int)(width * zoom), (int)(height * zoom), SDL_WINDOW_RESIZABLE);
+		renderer = window ? SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC) : NULL;
+		if (window && !renderer)
+			renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE);
+		atlas = renderer ? SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+			SDL_TEXTUREACCESS_STREAMING, width, height) : NULL;
+	}
+	if (!atlas || !start_workers(mosaic))
+	{
+		fprintf(stderr, "Unable to show %d instances: %s\n", mosaic->instance_count, SDL_GetError());
+		status = -1;
+	}
+	else
+	{
+		SDL_RenderSetLogicalSize(renderer, width, height);
+		for (int i = 0; i < width * height; ++i)
+			pixels[i] = VIDEO_BLACK;
+		SDL_UpdateTexture(atlas, NULL, pixels, pitch);
+	}
+
+	for (long shown = 0; status == 0 && (frames <= 0 || shown < frames); ++shown)
+	{
+		uint64_t frame_start = SDL_GetPerformanceCounter();
+		SDL_Event event;
+		int quit = 0;
+		// Bounds of the cells that changed, in cells
+		int left = columns, top = rows, right = -1, bottom = -1;
+		while (SDL_PollEvent(&event))
+		{
+			if (event.type == SDL_QUIT ||
+				(event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE))
+				quit = 1;
+			if (event.type == SDL_WINDOWEVENT || event.type == SDL_RENDER_TARGETS_RESET ||
+				event.type == SDL_RENDER_DEVICE_RESET)
+				present_needed = 1;
+		}
+		if (quit)
+			break;
+		for (int i = 0; i < mosaic->instance_count; ++i)
+		{
+			Instance *instance = &mosaic->instances[i];
+			int column = i % columns, row = i / columns;
+			uint32_t *cell = pixels + (size_t)row * SCREEN_HEIGHT * width + column * SCREEN_WIDTH;
+			uint32_t dirty;
+			int complete, count;
+			const uint8_t *vram = framequeue_take(instance->queue, &dirty, &complete);
+			if (!vram)
+				continue;
+			dirty = video_changed_strips(vram, instance->shown, dirty);
+			if (!dirty)
+				continue;
+			for (int strip = 0; (count = next_run(dirty, &strip)) > 0;)
+				video_convert_strips(vram, cell + (strip - count) * VIDEO_STRIP_COLUMNS,
+					pitch, strip - count, count);
+			if (column < left) left = column;
+			if (column > right) right = column;
+			if (row < top) top = row;
+			if (row > bottom) bottom = row;
+		}
+		// Every changed cell goes up in one upload of the rectangle
+		// around them.
+		if (right >= 0)
+		{
+			SDL_Rect rect;
+			rect.x = left * SCREEN_WIDTH;
+			rect.y = top * SCREEN_HEIGHT;
+			rect.w = (right - left + 1) * SCREEN_WIDTH;
+			rect.h = (bottom - top + 1) * SCREEN_HEIGHT;
+			SDL_UpdateTexture(atlas, &rect, pixels + (size_t)rect.y * width + rect.x, pitch);
+			present_needed = 1;
+		}
+		if (present_needed)
+		{
+			SDL_RenderClear(renderer);
+			SDL_RenderCopy(renderer, atlas, NULL, NULL);
+			SDL_RenderPresent(renderer);
+			present_needed = 0;
+		}
+		pace(frame_start);
+	}
+
+	stop_workers(mosaic);
+	if (atlas) SDL_DestroyTexture(atlas);
+	if (renderer) SDL_DestroyRenderer(renderer);
+	if (window) SDL_DestroyWindow(window);
+	free(pixels);
+	SDL_Quit();
+	return status;
+}
+
+// Releases the mosaic
+void mosaic_destroy(Mosaic *mosaic)
+{
+	if (!mosaic)
+		return;
+	stop_workers(mosaic);
+	for (int i = 0; i < mosaic->instance_count; ++i)
+		framequeue_destroy(mosaic->instances[i].queue);
+	for (int w = 0; w < mosaic->worker_count; ++w)
+		arena_destroy(mosaic->workers[w].arena);
+	pagepool_destroy(mosaic->pages);
+	free(mosaic->instances);
+	free(mosaic->workers);
+	free(mosaic);
+}
@@ -0,0 +1,72 @@
+/*******************************************************************************
+ * File: mosaic.h
+ *
+ * Purpose:
+ *		Runs a farm of emulator instances and shows them as a grid in one window.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "cpu.h"
+#include "dedup.h"
+
+/*
+ * Runs many copies of the machine at once and shows them side by side, for
+ * keeping an eye on a farm of instances. Every instance starts from a golden
+ * snapshot of one booted machine, lives in a CPU arena owned by the worker
+ * thread that runs it, and is steered by its own stream of pseudo-random
+ * input so the copies soon diverge.
+ *
+ * Workers publish each finished frame into a per-instance frame queue and
+ * never wait for the viewer; the viewer takes whatever is newest, converts
+ * the changed strips into one atlas of cells and uploads it to the screen
+ * with a single texture update per frame.
+ */
+typedef struct Mosaic Mosaic;
+
+/**
+ * Creates instances copies of the booted machine spread over threads worker
+ * threads (one per CPU if threads is 0), ready to start. Returns NULL if they
+ * can't be allocated.
+ */
+Mosaic *mosaic_create(CPUState *booted, int instances, int threads);
+
+/**
+ * Shares the memory pages that are identical across instances, as they all
+ * are right after creation, copy-on-write (see pagepool_dedup()). Call before
+ * mosaic_view(); returns -1 where pages can't be shared.
+ */
+int mosaic_dedup(Mosaic *mosaic, DedupStats *stats);
+
+/**
+ * Opens a window, starts the workers and shows the grid until the window is
+ * closed or, if frames is positive, that many frames have been shown.
+ * Returns 0, or -1 with a message if the window can't be created.
+ */
+int mosaic_view(Mosaic *mosaic, long frames);
+
+/**
+ * Stops the workers and releases every instance.
+ */
+void mosaic_destroy(Mosaic *mosaic);
@@ -0,0 +1,307 @@
+/*******************************************************************************
+ * File: movie.c
+ *
+ * Purpose:
+ *		Implementation of input recordings and their replay.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#include "movie.h"
+
+#include "bytes.h"
+#include "hash.h"
+#include "memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MOVIE_PORTS 4
+#define MOVIE_INFO_SIZE 12
+#define NO_CHANGE UINT32_MAX
+
+struct Movie {
+	int playing;
+	uint8_t *input; // Encoded port changes
+	size_t input_size;
+	size_t input_capacity;
+	size_t input_position; // Next change to apply when playing
+	uint32_t change_frame; // Frame of the last change recorded, or the next one to play
+	uint32_t *hashes;
+	uint32_t frame_count;
+	uint32_t hash_capacity;
+	uint32_t frame;
+	uint8_t ports[MOVIE_PORTS]; // Port values as of the last recorded change
+	uint64_t start_hash;
+	// A hash per memory page, kept current through the write epochs, then
+	// the encoded registers. The state hash is the hash of this buffer.
+	uint8_t digest[MEMORY_PAGES * 8 + SAVESTATE_CPU_SIZE];
+	uint32_t mark;
+};
+
+// Hashes the CPU state, rehashing only the pages written since the last call
+// unless full is set
+static uint64_t hash_state(Movie *movie, CPUState *state, int full)
+{
+	for (int page = 0; page < MEMORY_PAGES; ++page)
+	{
+		if (full || pageWrittenSince(state, page, movie->mark))
+			put_le64(movie->digest + page * 8,
+				hash_bytes(state->memory + (page << MEMORY_PAGE_SHIFT), MEMORY_PAGE_SIZE));
+	}
+	movie->mark = beginWriteEpoch(state);
+	savestate_write_cpu(state, movie->digest + MEMORY_PAGES * 8);
+	return hash_bytes(movie->digest, sizeof(movie->digest));
+}
+
+// Makes room for more encoded input
+static int reserve_input(Movie *movie, size_t extra)
+{
+	if (movie->input_size + extra > movie->input_capacity)
+	{
+		size_t capacity = movie->input_capacity ? movie->input_capacity * 2 : 1024;
+		uint8_t *input = realloc(movie->input, capacity);
+		if (!input)
+			return 0;
+		movie->input = input;
+		movie->input_capacity = capacity;
+	}
+	return 1;
+}
+
+// Decodes the frame of the next change to play back
+static void read_change_frame(Movie *movie)
+{
+	uint32_t delta = 0;
+	for (int shift = 0; shift < 35; shift += 7)
+	{
+		uint8_t byte;
+		if (movie->input_position >= movie->input_size)
+			break;
+		byte = movie->input[movie->input_position++];
+		delta |= (uint32_t)(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+		{
+			// The port and value follow the delta.
+			if (movie->input_size - movie->input_position >= 2)
+			{
+				movie->change_frame += delta;
+				return;
+			}
+			break;
+		}
+	}
+	movie->change_frame = NO_CHANGE;
+}
+
+// Starts recording
+Movie *movie_record(CPUState *state)
+{
+	Movie *movie = calloc(1, sizeof(Movie));
+	if (!movie)
+		return NULL;
+	memcpy(movie->ports, state->input_ports, MOVIE_PORTS);
+	movie->start_hash = hash_state(movie, state, 1);
+	return movie;
+}
+
+// Loads a movie and checks it starts from this state
+Movie *movie_play(const char *path, CPUState *state)
+{
+	size_t size;
+	uint8_t *file = savestate_load_file(path, &size);
+	const uint8_t *info, *input, *hashes;
+	uint32_t info_size, input_size, hashes_size;
+	Movie *movie;
+
+	if (!file)
+	{
+		fprintf(stderr, "Unable to read movie %s\n", path);
+		return NULL;
+	}
+	info = savestate_find_chunk(file, size, MOVIE_TAG_INFO, &info_size);
+	input = savestate_find_chunk(file, size, MOVIE_TAG_INPUT, &input_size);
+	hashes = savestate_find_chunk(file, size, MOVIE_TAG_HASHES, &hashes_size);
+	if (!info || !input || !hashes || info_size < MOVIE_INFO_SIZE ||
+		hashes_size / 4 < get_le32(info))
+	{
+		fprintf(stderr, "%s is not a valid movie\n", path);
+		free(file);
+		return NULL;
+	}
+
+	movie = calloc(1, sizeof(Movie));
+	if (!movie)
+	{
+		free(file);
+		return NULL;
+	}
+	movie->playing = 1;
+	movie->frame_count = get_le32(info);
+	movie->start_hash = get_le64(info + 4);
+	movie->input = malloc(input_size ? input_size : 1);
+	movie->hashes = malloc(movie->frame_count ? movie->frame_count * sizeof(uint32_t) : 1);
+	if (!movie->input || !movie->hashes)
+	{
+		free(file);
+		movie_destroy(movie);
+		return NULL;
+	}
+	memcpy(movie->input, input, input_size);
+	movie->input_size = input_size;
+	for (uint32_t frame = 0; frame < movie->frame_count; ++frame)
+		movie->hashes[frame] = get_le32(hashes + frame * 4);
+	free(file);
+
+	if (hash_state(movie, state, 1) != movie->start_hash)
+	{
+		fprintf(stderr, "%s was recorded from a different starting state (different ROMs?)\n", path);
+		movie_destroy(movie);
+		return NULL;
+	}
+	read_change_frame(movie);
+	return movie;
+}
+
+// Records or applies the input for the coming frame
+void movie_begin_frame(Movie *movie, CPUState *state)
+{
+	if (movie->playing)
+	{
+		while (movie->change_frame == movie->frame)
+		{
+			uint8_t port = movie->input[movie->input_position++];
+			uint8_t value = movie->input[movie->input_position++];
+			if (port < MOVIE_PORTS)
+				state->input_ports[port] = value;
+			read_change_frame(movie);
+		}
+		return;
+	}
+
+	for (uint8_t port = 0; port < MOVIE_PORTS; ++port)
+	{
+		uint32_t delta = movie->frame - movie->change_frame;
+		if (state->input_ports[port] == movie->ports[port] || !reserve_input(movie, 7))
+			continue;
+		while (delta >= 0x80)
+		{
+			movie->input[movie->input_size++] = (uint8_t)(delta | 0x80);
+			delta >>= 7;
+		}
+		movie->input[movie->input_size++] = (uint8_t)delta;
+		movie->input[movie->input_size++] = port;
+		movie->input[movie->input_size++] = state->input_ports[port];
+		movie->ports[port] = state->input_ports[port];
+		movie->change_frame = movie->frame;
+	}
+}
+
+// Records or checks the hash of the frame just run
+int movie_end_frame(Movie *movie, CPUState *state)
+{
+	uint32_t hash = (uint32_t)hash_state(movie, state, 0);
+	uint32_t frame = movie->frame++;
+
+	if (movie->playing)
+		return frame >= movie->frame_count || movie->hashes[frame] == hash;
+
+	if (movie->frame_count == movie->hash_capacity)
+	{
+		uint32_t capacity = movie->hash_capacity ? movie->hash_capacity * 2 : 3600;
+		uint32_t *hashes = realloc(movie->hashes, capacity * sizeof(uint32_t));
+		if (!hashes)
+			return 1;
+		movie->hashes = hashes;
+		movie->hash_capacity = capacity;
+	}
+	movie->hashes[movie->frame_count++] = hash;
+	return 1;
+}
+
+// Moves playback to the start of a frame
+void movie_seek(Movie *movie, uint32_t frame)
+{
+	if (!movie->playing)
+		return;
+	movie->frame = frame;
+	movie->input_position = 0;
+	movie->change_frame = 0;
+	read_change_frame(movie);
+	while (movie->change_frame < frame)
+	{
+		movie->input_position += 2;
+		read_change_frame(movie);
+	}
+}
+
+// Frames recorded or played so far
+uint32_t movie_frame(const Movie *movie)
+{
+	return movie->frame;
+}
+
+// Tests whether playback has reached the end
+int movie_finished(const Movie *movie)
+{
+	return movie->playing && movie->frame >= movie->frame_count;
+}
+
+// Writes a recording to a file
+int movie_save(const Movie *movie, const char *path)
+{
+	size_t size = SAVESTATE_HEADER_SIZE + 3 * SAVESTATE_CHUNK_HEADER_SIZE +
+		MOVIE_INFO_SIZE + movie->input_size + (size_t)movie->frame_count * 4;
+	uint8_t *out = malloc(size), *cursor = out;
+	int result;
+
+	if (!out)
+		return -1;
+	savestate_write_header(cursor, 3, (uint32_t)size);
+	cursor += SAVESTATE_HEADER_SIZE;
+	cursor = savestate_write_chunk(cursor, MOVIE_TAG_INFO, MOVIE_INFO_SIZE);
+	put_le32(cursor, movie->frame_count);
+	put_le64(cursor + 4, movie->start_hash);
+	cursor += MOVIE_INFO_SIZE;
+	cursor = savestate_write_chunk(cursor, MOVIE_TAG_INPUT, (uint32_t)movie->input_size);
+	if (movie->input_size)
+		memcpy(cursor, movie->input, movie->input_size);
+	cursor += movie->input_size;
+	cursor = savestate_write_chunk(cursor, MOVIE_TAG_HASHES, movie->frame_count * 4);
+	for (uint32_t frame = 0; frame < movie->frame_count; ++frame)
+		put_le32(cursor + frame * 4, movie->hashes[frame]);
+
+	result = savestate_save_file(path, out, size);
+	free(out);
+	return result;
+}
+
+// Releases a movie
+void movie_destroy(Movie *movie)
+{
+	if (!movie)
+		return;
+	free(movie->input);
+	free(movie->hashes);
+	free(movie);
+}
@@ -0,0 +1,104 @@
+/*******************************************************************************
+ * File: movie.h
+ *
+ * Purpose:
+ *		Specification for input recordings and their replay.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "cpu.h"
+#include "savestate.h"
+
+#include <stdint.h>
+
+/*
+ * A movie is a save-state container holding no machine state, only what is
+ * needed to replay a session from a known starting point:
+ *
+ *   "MOVI": u32 frame count, u64 hash of the state the movie starts from
+ *   "INPT": input port changes, each a LEB128 frame delta from the previous
+ *           change, a u8 port number and the port's new u8 value
+ *   "HASH": u32 state hash at the end of every frame
+ *
+ * The input ports are the machine's only source of nondeterminism, so
+ * replaying the changes from the same starting state reproduces the session
+ * exactly; the frame hashes catch the first frame where it doesn't.
+ */
+#define MOVIE_TAG_INFO SAVESTATE_TAG('M', 'O', 'V', 'I')
+#define MOVIE_TAG_INPUT SAVESTATE_TAG('I', 'N', 'P', 'T')
+#define MOVIE_TAG_HASHES SAVESTATE_TAG('H', 'A', 'S', 'H')
+
+typedef struct Movie Movie;
+
+/**
+ * Starts recording from the current CPU state.
+ */
+Movie *movie_record(CPUState *state);
+
+/**
+ * Loads a movie for playback from the current CPU state. Returns NULL, after
+ * printing why, if the file can't be read or was recorded from a different
+ * starting state (usually different ROMs).
+ */
+Movie *movie_play(const char *path, CPUState *state);
+
+/**
+ * Call before running each frame. When recording, notes any input ports the
+ * player changed; when playing, sets the ports as they were recorded.
+ */
+void movie_begin_frame(Movie *movie, CPUState *state);
+
+/**
+ * Call after running each frame. Records the state hash, or compares it with
+ * the recorded one. Returns 0 on a mismatch, non-zero otherwise.
+ */
+int movie_end_frame(Movie *movie, CPUState *state);
+
+/**
+ * Moves playback to the start of a frame, for a CPU state restored to that
+ * point. Changes from earlier frames are skipped since the restored ports
+ * already reflect them.
+ */
+void movie_seek(Movie *movie, uint32_t frame);
+
+/**
+ * Number of frames recorded, or played back so far.
+ */
+uint32_t movie_frame(const Movie *movie);
+
+/**
+ * Tests whether every recorded frame has been played back.
+ */
+int movie_finished(const Movie *movie);
+
+/**
+ * Writes a recording to a file. Returns 0 on success, -1 on failure.
+ */
+int movie_save(const Movie *movie, const char *path);
+
+/**
+ * Releases a movie.
+ */
+void movie_destroy(Movie *movie);
@@ -0,0 +1,317 @@
+/*******************************************************************************
+ * File: observer.c
+ *
+ * Purpose:
+ *		Downsampled greyscale observations of the screen for learning agents.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#include "observer.h"
+
+#include "video.h"
+
+#include <SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OBSERVER_SSE2
+#include <emmintrin.h>
+#endif
+
+// As in video.c: a build for AVX2 always uses it, and a plain x86 build with
+// GCC or Clang compiles the AVX2 functions for their own target and picks
+// them at run time when the CPU has AVX2.
+#if defined(__AVX2__)
+#define OBSERVER_AVX2
+#define OBSERVER_AVX2_TARGET
+#include <immintrin.h>
+#elif defined(OBSERVER_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define OBSERVER_AVX2
+#define OBSERVER_AVX2_DISPATCH
+#define OBSERVER_AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+/*
+ * Video memory is already stored column by column, so rather than rotating
+ * the screen upright and then shrinking it, each column's 256 bits are
+ * spread out to one byte per pixel and added into a profile of how many
+ * pixels are lit at each height across the columns of a box. Summing that
+ * profile over each row's heights gives every box's count, scaled to 0-255.
+ */
+
+struct Observer {
+	int width;
+	int height;
+	int stack;
+	int max_pool;
+	int newest; // Slot of the latest observation in frames
+	int have_previous;
+	uint8_t previous[VIDEO_BYTES]; // Last frame pushed, for max pooling
+	uint8_t pooled[VIDEO_BYTES];
+	uint8_t *frames; // stack observations, used as a ring
+};
+
+typedef void (*AddColumn)(const uint8_t *column, uint8_t profile[SCREEN_HEIGHT]);
+typedef void (*OrFrames)(const uint8_t *a, const uint8_t *b, uint8_t *out);
+
+// The fastest versions the CPU runs, chosen on first use
+static AddColumn add_column;
+static OrFrames or_frames;
+static SDL_atomic_t kernels_ready;
+
+#if defined(OBSERVER_AVX2)
+
+// Adds one to the profile at the height of every lit pixel in a column
+OBSERVER_AVX2_TARGET static void add_column_avx2(const uint8_t *column, uint8_t profile[SCREEN_HEIGHT])
+{
+	// Byte i of each 4 goes to 8 lanes, and each lane tests its own bit.
+	const __m256i spread = _mm256_setr_epi8(
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+		2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+	const __m256i bits = _mm256_set1_epi64x((long long)0x8040201008040201ull);
+	for (int byte = 0; byte < VIDEO_COLUMN_BYTES; byte += 4)
+	{
+		uint32_t word;
+		__m256i lanes, count;
+		memcpy(&word, column + byte, sizeof(word));
+		lanes = _mm256_shuffle_epi8(_mm256_set1_epi32((int)word), spread);
+		lanes = _mm256_cmpeq_epi8(_mm256_and_si256(lanes, bits), bits);
+		count = _mm256_loadu_si256((const __m256i *)(profile + byte * 8));
+		_mm256_storeu_si256((__m256i *)(profile + byte * 8), _mm256_sub_epi8(count, lanes));
+	}
+}
+
+// ORs two frames together
+OBSERVER_AVX2_TARGET static void or_frames_avx2(const uint8_t *a, const uint8_t *b, uint8_t *out)
+{
+	for (int i = 0; i < VIDEO_BYTES; i += 32)
+		_mm256_storeu_si256((__m256i *)(out + i), _mm256_or_si256(
+			_mm256_loadu_si256((const __m256i *)(a + i)), _mm256_loadu_si256((const __m256i *)(b + i))));
+}
+
+#endif
+
+#if defined(OBSERVER_SSE2) && (!defined(OBSERVER_AVX2) || defined(OBSERVER_AVX2_DISPATCH))
+
+// Adds one to the profile at the height of every lit pixel in a column
+static void add_column_sse2(const uint8_t *column, uint8_t profile[SCREEN_HEIGHT])
+{
+	const __m128i bits = _mm_set_epi32(0x80402010, 0x08040201, 0x80402010, 0x08040201);
+	for (int half = 0; half < VIDEO_COLUMN_BYTES; half += 16)
+	{
+		// Unpacking each byte with itself three times spreads it over 8
+		// lanes, two bytes to a vector; each lane then tests its own bit.
+		__m128i bytes = _mm_loadu_si128((const __m128i *)(column + half));
+		__m128i pairs[2], quads[4], spread[8];
+		pairs[0] = _mm_unpacklo_epi8(bytes, bytes);
+		pairs[1] = _mm_unpackhi_epi8(bytes, bytes);
+		for (int i = 0; i < 2; ++i)
+		{
+			quads[2 * i] = _mm_unpacklo_epi16(pairs[i], pairs[i]);
+			quads[2 * i + 1] = _mm_unpackhi_epi16(pairs[i], pairs[i]);
+		}
+		for (int i = 0; i < 4; ++i)
+		{
+			spread[2 * i] = _mm_unpacklo_epi32(quads[i], quads[i]);
+			spread[2 * i + 1] = _mm_unpackhi_epi32(quads[i], quads[i]);
+		}
+		for (int i = 0; i < 8; ++i)
+		{
+			uint8_t *out = profile + (half + 2 * i) * 8;
+			__m128i lanes = _mm_cmpeq_epi8(_mm_and_si128(spread[i], bits), bits);
+			_mm_storeu_si128((__m128i *)out, _mm_sub_epi8(_mm_loadu_si128((const __m128i *)out), lanes));
+		}
+	}
+}
+
+// ORs two frames together
+static void or_frames_sse2(const uint8_t *a, const uint8_t *b, uint8_t *out)
+{
+	for (int i = 0; i < VIDEO_BYTES; i += 16)
+		_mm_storeu_si128((__m128i *)(out + i), _mm_or_si128(
+			_mm_loadu_si128((const __m128i *)(a + i)), _mm_loadu_si128((const __m128i *)(b + i))));
+}
+
+#elif !defined(OBSERVER_SSE2)
+
+// Adds one to the profile at the height of every lit pixel in a column
+static void add_column_scalar(const uint8_t *column, uint8_t profile[SCREEN_HEIGHT])
+{
+	for (int byte = 0; byte < VIDEO_COLUMN_BYTES; ++byte)
+		for (int bit = 0; bit < 8; ++bit)
+			profile[byte * 8 + bit] += (column[byte] >> bit) & 1;
+}
+
+// ORs two frames together
+static void or_frames_scalar(const uint8_t *a, const uint8_t *b, uint8_t *out)
+{
+	for (int i = 0; i < VIDEO_BYTES; ++i)
+		out[i] = a[i] | b[i];
+}
+
+#endif
+
+// Picks the column and frame functions for the CPU
+static void pick_kernels(void)
+{
+#if defined(OBSERVER_AVX2_DISPATCH)
+	int avx2 = SDL_HasAVX2();
+	add_column = avx2 ? add_column_avx2 : add_column_sse2;
+	or_frames = avx2 ? or_frames_avx2 : or_frames_sse2;
+#elif defined(OBSERVER_AVX2)
+	add_column = add_column_avx2;
+	or_frames = or_frames_avx2;
+#elif defined(OBSERVER_SSE2)
+	add_column = add_column_sse2;
+	or_frames = or_frames_sse2;
+#else
+	add_column = add_column_scalar;
+	or_frames = or_frames_scalar;
+#endif
+	SDL_AtomicSet(&kernels_ready, 1);
+}
+
+// Shrinks video memory to a greyscale image
+void observer_downsample(const uint8_t *vram, uint8_t *out, int width, int height)
+{
+	// Row r's boxes cover heights edge[r + 1] to edge[r] - 1 counted from the
+	// bottom of the screen; row 0 is the top row
+	int edge[SCREEN_HEIGHT + 1];
+	// 255 / box area in 16.16 fixed point, for boxes narrow_width and one wider
+	uint32_t scale[2][SCREEN_HEIGHT];
+	uint8_t profile[SCREEN_HEIGHT];
+	int narrow_width = SCREEN_WIDTH / width;
+	int x = 0;
+
+	if (!SDL_AtomicGet(&kernels_ready))
+		pick_kernels();
+	for (int row = 0; row <= height; ++row)
+		edge[row] = SCREEN_HEIGHT - row * SCREEN_HEIGHT / height;
+	for (int row = 0; row < height; ++row)
+	{
+		uint32_t box_height = (uint32_t)(edge[row] - edge[row + 1]);
+		for (int wide = 0; wide < 2; ++wide)
+		{
+			uint32_t area = (uint32_t)(narrow_width + wide) * box_height;
+			scale[wide][row] = ((255u << 16) + area / 2) / area;
+		}
+	}
+
+	for (int box = 0; box < width; ++box)
+	{
+		int end = (box + 1) * SCREEN_WIDTH / width;
+		const uint32_t *box_scale = scale[end - x > narrow_width];
+		// A box is at most SCREEN_WIDTH columns wide, so no count overflows.
+		memset(profile, 0, sizeof(profile));
+		for (; x < end; ++x)
+			add_column(vram + x * VIDEO_COLUMN_BYTES, profile);
+		for (int row = 0; row < height; ++row)
+		{
+			uint32_t lit = 0;
+			for (int height_bit = edge[row + 1]; height_bit < edge[row]; ++height_bit)
+				lit += profile[height_bit];
+			out[row * width + box] = (uint8_t)((lit * box_scale[row] + 0x8000) >> 16);
+		}
+	}
+}
+
+// Creates an observer
+Observer *observer_create(int width, int height, int stack, int max_pool)
+{
+	Observer *observer;
+	if (width < 1 || width > SCREEN_WIDTH || height < 1 || height > SCREEN_HEIGHT || stack < 1)
+		return NULL;
+	observer = calloc(1, sizeof(Observer));
+	if (!observer)
+		return NULL;
+	observer->width = width;
+	observer->height = height;
+	observer->stack = stack;
+	observer->max_pool = max_pool;
+	observer->frames = calloc((size_t)stack * width * height, 1);
+	if (!observer->frames)
+	{
+		free(observer);
+		return NULL;
+	}
+	return observer;
+}
+
+// Takes an observation of a frame
+void observer_push(Observer *observer, const uint8_t *vram)
+{
+	size_t size = (size_t)observer->width * observer->height;
+	const uint8_t *source = vram;
+	observer->newest = (observer->newest + 1) % observer->stack;
+	if (observer->max_pool)
+	{
+		if (observer->have_previous)
+		{
+			if (!SDL_AtomicGet(&kernels_ready))
+				pick_kernels();
+			or_frames(vram, observer->previous, observer->pooled);
+			source = observer->pooled;
+		}
+		memcpy(observer->previous, vram, VIDEO_BYTES);
+		observer->have_previous = 1;
+	}
+	observer_downsample(source, observer->frames + observer->newest * size,
+		observer->width, observer->height);
+}
+
+// Bytes in a stack of observations
+size_t observer_size(const Observer *observer)
+{
+	return (size_t)observer->stack * observer->width * observer->height;
+}
+
+// Copies out the stack, oldest first
+void observer_read(const Observer *observer, uint8_t *out)
+{
+	size_t size = (size_t)observer->width * observer->height;
+	for (int i = 1; i <= observer->stack; ++i)
+	{
+		int slot = (observer->newest + i) % observer->stack;
+		memcpy(out, observer->frames + slot * size, size);
+		out += size;
+	}
+}
+
+// Forgets every frame
+void observer_reset(Observer *observer)
+{
+	memset(observer->frames, 0, observer_size(observer));
+	observer->newest = 0;
+	observer->have_previous = 0;
+}
+
+// Releases an observer
+void observer_destroy(Observer *observer)
+{
+	if (!observer)
+		return;
+	free(observer->frames);
+	free(observer);
+}
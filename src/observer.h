@@ -0,0 +1,83 @@
+/*******************************************************************************
+ * File: observer.h
+ *
+ * Purpose:
+ *		Downsampled greyscale observations of the screen for learning agents.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Shrinks the screen to a small greyscale image straight from video memory,
+ * for agents that learn from pixels, e.g. 84x84 or 112x128. The screen is
+ * split into width x height boxes as even as whole pixels allow, and each
+ * output byte is the share of lit pixels in its box scaled to 0-255. Rows run
+ * top to bottom and the image is upright, as on the cabinet.
+ */
+typedef struct Observer Observer;
+
+/**
+ * Writes a width x height observation of vram (VIDEO_BYTES bytes starting at
+ * VIDEO_RAM) to out, one byte per pixel, row by row. width may be 1 to
+ * SCREEN_WIDTH and height 1 to SCREEN_HEIGHT.
+ */
+void observer_downsample(const uint8_t *vram, uint8_t *out, int width, int height);
+
+/**
+ * Creates an observer that keeps the last stack observations of the given
+ * size. With max_pool set, each observation is taken from the two most
+ * recent frames with every pixel lit in either, so sprites that flicker
+ * between frames don't vanish. Returns NULL if the size is out of range or
+ * it can't be allocated.
+ */
+Observer *observer_create(int width, int height, int stack, int max_pool);
+
+/**
+ * Takes an observation of the frame that just finished.
+ */
+void observer_push(Observer *observer, const uint8_t *vram);
+
+/**
+ * Number of bytes observer_read() writes: stack x height x width.
+ */
+size_t observer_size(const Observer *observer);
+
+/**
+ * Writes the stacked observations to out, oldest first. Observations from
+ * before the first pushes (or the last reset) are black.
+ */
+void observer_read(const Observer *observer, uint8_t *out);
+
+/**
+ * Forgets every frame pushed so far, e.g. at the start of an episode.
+ */
+void observer_reset(Observer *observer);
+
+/**
+ * Releases an observer.
+ */
+void observer_destroy(Observer *observer);
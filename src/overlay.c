@@ -0,0 +1,72 @@
+/*******************************************************************************
+ * File: overlay.c
+ *
+ * Purpose:
+ *		Implementation of loading colour overlays from a file.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#include "overlay.h"
+
+#include <stdio.h>
+
+// Loads an overlay file
+int overlay_load(const char *path, VideoOverlay *overlay)
+{
+	char line[256];
+	int number = 0;
+	FILE *f = fopen(path, "r");
+	if (!f)
+	{
+		fprintf(stderr, "Unable to read overlay %s\n", path);
+		return -1;
+	}
+	for (int y = 0; y < SCREEN_HEIGHT; ++y)
+		for (int strip = 0; strip < VIDEO_STRIPS; ++strip)
+			overlay->colour[y][strip] = VIDEO_WHITE;
+
+	while (fgets(line, sizeof(line), f))
+	{
+		int top, bottom, left = 0, right = SCREEN_WIDTH - 1, fields;
+		unsigned rgb;
+		char first = '#';
+		++number;
+		sscanf(line, " %c", &first);
+		if (first == '#')
+			continue;
+		fields = sscanf(line, "%d %d %x %d %d", &top, &bottom, &rgb, &left, &right);
+		if ((fields != 3 && fields != 5) || top < 0 || bottom >= SCREEN_HEIGHT || top > bottom ||
+			left < 0 || right >= SCREEN_WIDTH || left > right || rgb > 0xffffff)
+		{
+			fprintf(stderr, "%s:%d: expected \"top bottom rrggbb [left right]\" within the screen\n",
+				path, number);
+			fclose(f);
+			return -1;
+		}
+		for (int y = top; y <= bottom; ++y)
+			for (int strip = left / VIDEO_STRIP_COLUMNS; strip <= right / VIDEO_STRIP_COLUMNS; ++strip)
+				overlay->colour[y][strip] = 0xff000000u | rgb;
+	}
+	fclose(f);
+	return 0;
+}
@@ -1,10 +1,10 @@
 /*******************************************************************************
- * File: time.h
+ * File: overlay.h
  *
  * Purpose:
- *		Provides an equivalent of the *nix interface for working with time.
+ *		Specification for loading colour overlays from a file.
  *
- * Copyright 2018, 2026 Adam Thompson <adam@hackeradam.com>
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
  *
  * Permission is hereby granted, free of charge, to any person obtaining a copy
  * of this software and associated documentation files (the "Software"), to deal
@@ -28,27 +28,21 @@
 
 #pragma once
 
-#include <Windows.h>
+#include "video.h"
 
-/**
- * Provides an equivilant of the *nix API for getting the current time of day.
-*/
-int gettimeofday(struct timeval *tp, struct timezone *tzp)
-{
-  // Time since the EPOCH
-  static const uint64_t EPOCH = ((uint64_t)116444736000000000ULL);
-
-  SYSTEMTIME  system_time;
-  FILETIME    file_time;
-  uint64_t    time;
-
-  GetSystemTime(&system_time);
-  SystemTimeToFileTime(&system_time, &file_time);
-  time = ((uint64_t)file_time.dwLowDateTime);
-  time += ((uint64_t)file_time.dwHighDateTime) << 32;
-
-  tp->tv_sec = (long)((time - EPOCH) / 10000000L);
-  tp->tv_usec = (long)(system_time.wMilliseconds * 1000);
-  return 0;
-}
+/*
+ * An overlay file describes the gel strips as lines of
+ *
+ *     top bottom rrggbb [left right]
+ *
+ * giving the colour of rows top to bottom (0 is the top of the upright
+ * screen), optionally only between columns left and right, which are rounded
+ * out to whole strips of 8. Later lines cover earlier ones; anything no line
+ * covers stays white. Blank lines and lines starting with # are ignored.
+ */
 
+/**
+ * Loads an overlay file. Returns 0 on success, or -1 after reporting why the
+ * file couldn't be used.
+ */
+int overlay_load(const char *path, VideoOverlay *overlay);
@@ -28,13 +28,27 @@
 
 #include "platform.h"
 
+#include "bytes.h"
+#include "frame.h"
+#include "memory.h"
+#include "savestate.h"
+#include "scale.h"
+#include "soundqueue.h"
+#include "video.h"
+
 #include <SDL.h>
+#include <stdio.h>
 #include <stdlib.h>
 
-#define SCREEN_WIDTH 224
-#define SCREEN_HEIGHT 256
-#define VIDEO_RAM 0x2400
 #define AUDIO_RATE 48000
+#define AUDIO_SAMPLES 512
+#define INSTRUCTIONS_PER_SECOND (FRAME_INSTRUCTIONS * 60)
+/* How far behind the CPU sounds are played, in samples: a frame's events all
+ * arrive at once when it has been emulated, and must be queued before the
+ * callback renders the buffer they fall in. */
+#define SOUND_LATENCY (AUDIO_RATE / 60 + AUDIO_SAMPLES)
+#define VOICE_STATE_SIZE 17
+#define QUICKSAVE_PATH "invaders.sav"
 
 typedef struct Voice {
 	float phase;
@@ -47,24 +61,95 @@ typedef struct Voice {
 struct Platform {
 	SDL_Window *window;
 	SDL_Renderer *renderer;
-	SDL_Texture *texture;
-	uint32_t pixels[SCREEN_WIDTH * SCREEN_HEIGHT];
+	SDL_Texture *textures[2];
+	int texture_count;
+	int next_texture;
+	uint32_t texture_dirty[2]; // Strips each texture has yet to catch up on
+	uint8_t shown_vram[VIDEO_BYTES]; // Video memory as of the last frame drawn
+	uint8_t present_needed; // Set when the window must be redrawn regardless
+	uint8_t frame_changed; // Set when a strip has changed since the last present
+	Scaler *scaler; // Upscales on the CPU, or NULL to leave it to the renderer
+	uint32_t *frame; // Unscaled pixels the scaler works from
 	uint8_t coin_frames;
+	uint8_t rewinding;
+	uint8_t reset_requested;
+	uint8_t loads_disabled;
 	SDL_AudioDeviceID audio_device;
 	Voice voices[5];
 	uint32_t noise_state;
 	uint8_t last_sound3;
 	uint8_t last_sound5;
 	uint8_t ufo_active;
+	SoundQueue *sound_events; // Sound port writes on their way to the callback
+	uint64_t audio_samples; // Samples the callback has produced
+	int64_t sound_offset; // Added to an event's sample to get when it plays
+	uint8_t sound_anchored; // Set once sound_offset has been chosen
 };
 
+static void trigger_voice(Voice *voice, float frequency, float volume, int milliseconds, int noise)
+{
+	voice->phase = 0.0f;
+	voice->frequency = frequency;
+	voice->volume = volume;
+	voice->remaining = AUDIO_RATE * milliseconds / 1000;
+	voice->noise = noise;
+}
+
+/* Starts the sounds a write to a sound port turns on. */
+static void play_sound_event(Platform *p, const SoundEvent *event)
+{
+	if (event->port == 3) {
+		uint8_t rise3 = event->value & (uint8_t)~p->last_sound3;
+		p->ufo_active = event->value & 0x01;
+		if (rise3 & 0x02) trigger_voice(&p->voices[1], 700.0f, 0.20f, 180, 1); /* shot */
+		if (rise3 & 0x04) trigger_voice(&p->voices[2], 90.0f, 0.24f, 550, 1);  /* explosion */
+		if (rise3 & 0x08) trigger_voice(&p->voices[3], 420.0f, 0.16f, 100, 0); /* invader hit */
+		if (rise3 & 0x10) trigger_voice(&p->voices[3], 880.0f, 0.14f, 250, 0); /* bonus */
+		p->last_sound3 = event->value;
+	} else {
+		uint8_t rise5 = event->value & (uint8_t)~p->last_sound5;
+		for (int bit = 0; bit < 4; ++bit)
+			if (rise5 & (1u << bit))
+				trigger_voice(&p->voices[4], 85.0f + bit * 22.0f, 0.20f, 70, 0);
+		if (rise5 & 0x10) trigger_voice(&p->voices[2], 160.0f, 0.24f, 400, 1); /* UFO hit */
+		p->last_sound5 = event->value;
+	}
+}
+
+/* The sample an event plays on. The CPU and the sound card keep their own
+ * clocks, so the first event, and any that turns up after its sample has
+ * gone or implausibly far ahead of it (the emulator paused, fell behind or
+ * reset), sets the offset between them afresh. */
+static int64_t sound_event_due(Platform *p, const SoundEvent *event)
+{
+	int64_t sample = (int64_t)(event->time * AUDIO_RATE / INSTRUCTIONS_PER_SECOND);
+	int64_t now = (int64_t)p->audio_samples;
+	int64_t due = sample + p->sound_offset;
+	if (!p->sound_anchored || due < now || due > now + 3 * SOUND_LATENCY) {
+		p->sound_offset = now + SOUND_LATENCY - sample;
+		p->sound_anchored = 1;
+		due = now + SOUND_LATENCY;
+	}
+	return due;
+}
+
 static void audio_callback(void *userdata, Uint8 *stream, int length)
 {
 	Platform *p = userdata;
 	float *samples = (float *)stream;
 	int count = length / (int)sizeof(float);
-	for (int i = 0; i < count; ++i) {
+	const SoundEvent *event = soundqueue_peek(p->sound_events);
+	int64_t due = event ? sound_event_due(p, event) : 0;
+	for (int i = 0; i < count; ++i, ++p->audio_samples) {
 		float mixed = 0.0f;
+		/* Each sound starts on the sample matching the instruction that
+		 * wrote its port. */
+		while (event && due <= (int64_t)p->audio_samples) {
+			play_sound_event(p, event);
+			soundqueue_pop(p->sound_events);
+			event = soundqueue_peek(p->sound_events);
+			if (event) due = sound_event_due(p, event);
+		}
 		if (p->ufo_active) {
 			p->voices[0].phase += 110.0f / AUDIO_RATE;
 			if (p->voices[0].phase >= 1.0f) p->voices[0].phase -= 1.0f;
@@ -91,35 +176,9 @@ static void audio_callback(void *userdata, Uint8 *stream, int length)
 	}
 }
 
-static void trigger_voice(Voice *voice, float frequency, float volume, int milliseconds, int noise)
+SoundQueue *platform_sound_events(Platform *p)
 {
-	voice->phase = 0.0f;
-	voice->frequency = frequency;
-	voice->volume = volume;
-	voice->remaining = AUDIO_RATE * milliseconds / 1000;
-	voice->noise = noise;
-}
-
-static void update_sound(Platform *p, CPUState *state)
-{
-	uint8_t sound3 = state->output_ports[3];
-	uint8_t sound5 = state->output_ports[5];
-	uint8_t rise3 = sound3 & (uint8_t)~p->last_sound3;
-	uint8_t rise5 = sound5 & (uint8_t)~p->last_sound5;
-	if (!p->audio_device) return;
-	SDL_LockAudioDevice(p->audio_device);
-	p->ufo_active = sound3 & 0x01;
-	if (rise3 & 0x02) trigger_voice(&p->voices[1], 700.0f, 0.20f, 180, 1); /* shot */
-	if (rise3 & 0x04) trigger_voice(&p->voices[2], 90.0f, 0.24f, 550, 1);  /* explosion */
-	if (rise3 & 0x08) trigger_voice(&p->voices[3], 420.0f, 0.16f, 100, 0); /* invader hit */
-	if (rise3 & 0x10) trigger_voice(&p->voices[3], 880.0f, 0.14f, 250, 0); /* bonus */
-	for (int bit = 0; bit < 4; ++bit)
-		if (rise5 & (1u << bit))
-			trigger_voice(&p->voices[4], 85.0f + bit * 22.0f, 0.20f, 70, 0);
-	if (rise5 & 0x10) trigger_voice(&p->voices[2], 160.0f, 0.24f, 400, 1); /* UFO hit */
-	p->last_sound3 = sound3;
-	p->last_sound5 = sound5;
-	SDL_UnlockAudioDevice(p->audio_device);
+	return p->audio_device ? p->sound_events : NULL;
 }
 
 static void set_control(Platform *platform, CPUState *state, SDL_Keycode key, int down)
@@ -133,6 +192,9 @@ static void set_control(Platform *platform, CPUState *state, SDL_Keycode key, in
 			platform->coin_frames = 6;
 		}
 		return;
+	case SDLK_BACKSPACE:
+		platform->rewinding = (uint8_t)down;
+		return;
 	case SDLK_2: mask = 0x02; break;
 	case SDLK_1: mask = 0x04; break;
 	case SDLK_SPACE: mask = 0x10; break;
@@ -147,41 +209,141 @@ static void set_control(Platform *platform, CPUState *state, SDL_Keycode key, in
 	else state->input_ports[port] &= (uint8_t)~mask;
 }
 
-Platform *platform_create(void)
+void platform_save_state(Platform *p, uint8_t out[PLATFORM_STATE_SIZE])
+{
+	memset(out, 0, PLATFORM_STATE_SIZE);
+	if (p->audio_device) SDL_LockAudioDevice(p->audio_device);
+	for (int v = 0; v < 5; ++v) {
+		uint8_t *voice = out + v * VOICE_STATE_SIZE;
+		put_lef32(voice, p->voices[v].phase);
+		put_lef32(voice + 4, p->voices[v].frequency);
+		put_lef32(voice + 8, p->voices[v].volume);
+		put_le32(voice + 12, (uint32_t)p->voices[v].remaining);
+		voice[16] = (uint8_t)p->voices[v].noise;
+	}
+	put_le32(out + 85, p->noise_state);
+	out[89] = p->last_sound3;
+	out[90] = p->last_sound5;
+	out[91] = p->ufo_active;
+	out[92] = p->coin_frames;
+	if (p->audio_device) SDL_UnlockAudioDevice(p->audio_device);
+}
+
+int platform_load_state(Platform *p, const uint8_t *in, uint32_t size)
+{
+	if (size < PLATFORM_STATE_SIZE) return -1;
+	if (p->audio_device) SDL_LockAudioDevice(p->audio_device);
+	for (int v = 0; v < 5; ++v) {
+		const uint8_t *voice = in + v * VOICE_STATE_SIZE;
+		p->voices[v].phase = get_lef32(voice);
+		p->voices[v].frequency = get_lef32(voice + 4);
+		p->voices[v].volume = get_lef32(voice + 8);
+		p->voices[v].remaining = (int)get_le32(voice + 12);
+		p->voices[v].noise = voice[16];
+	}
+	p->noise_state = get_le32(in + 85);
+	p->last_sound3 = in[89];
+	p->last_sound5 = in[90];
+	p->ufo_active = in[91];
+	p->coin_frames = in[92];
+	if (p->audio_device) SDL_UnlockAudioDevice(p->audio_device);
+	return 0;
+}
+
+static void quick_save(Platform *p, CPUState *state)
+{
+	uint8_t chunk[PLATFORM_STATE_SIZE];
+	size_t size = savestate_size(PLATFORM_STATE_SIZE);
+	uint8_t *buffer = malloc(size);
+	if (!buffer) return;
+	platform_save_state(p, chunk);
+	savestate_write(state, chunk, PLATFORM_STATE_SIZE, buffer, size);
+	if (savestate_save_file(QUICKSAVE_PATH, buffer, size) != 0)
+		fprintf(stderr, "Unable to write %s\n", QUICKSAVE_PATH);
+	free(buffer);
+}
+
+static void quick_load(Platform *p, CPUState *state)
+{
+	size_t size;
+	const uint8_t *chunk;
+	uint32_t chunk_size;
+	uint8_t *buffer = savestate_load_file(QUICKSAVE_PATH, &size);
+	if (!buffer) return;
+	if (savestate_read(state, buffer, size, &chunk, &chunk_size) != 0)
+		fprintf(stderr, "%s is not a valid save state\n", QUICKSAVE_PATH);
+	else if (chunk)
+		platform_load_state(p, chunk, chunk_size);
+	free(buffer);
+}
+
+Platform *platform_create(int double_buffered, ScaleFilter filter, int scale, int scale_threads)
 {
 	Platform *p = calloc(1, sizeof(*p));
+	int factor = 1;
 	if (!p || SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_AUDIO) != 0) return NULL;
+	if (filter != SCALE_NONE) {
+		p->scaler = scaler_create(filter, scale, scale_threads);
+		p->frame = malloc(sizeof(uint32_t) * SCREEN_WIDTH * SCREEN_HEIGHT);
+		if (!p->scaler || !p->frame) {
+			platform_destroy(p);
+			return NULL;
+		}
+		factor = scaler_factor(p->scaler);
+		video_convert(p->shown_vram, p->frame, SCREEN_WIDTH * (int)sizeof(uint32_t));
+	}
+	/* A window the size of the scaled texture copies it 1:1. */
 	p->window = SDL_CreateWindow("Intel 8080 - Space Invaders", SDL_WINDOWPOS_CENTERED,
-		SDL_WINDOWPOS_CENTERED, SCREEN_WIDTH * 3, SCREEN_HEIGHT * 3, SDL_WINDOW_RESIZABLE);
+		SDL_WINDOWPOS_CENTERED, SCREEN_WIDTH * (factor > 1 ? factor : 3),
+		SCREEN_HEIGHT * (factor > 1 ? factor : 3), SDL_WINDOW_RESIZABLE);
 	p->renderer = SDL_CreateRenderer(p->window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
 	if (!p->renderer)
 		p->renderer = SDL_CreateRenderer(p->window, -1, SDL_RENDERER_SOFTWARE);
-	p->texture = SDL_CreateTexture(p->renderer, SDL_PIXELFORMAT_ARGB8888,
-		SDL_TEXTUREACCESS_STREAMING, SCREEN_WIDTH, SCREEN_HEIGHT);
-	if (!p->window || !p->renderer || !p->texture) { platform_destroy(p); return NULL; }
-	SDL_RenderSetLogicalSize(p->renderer, SCREEN_WIDTH, SCREEN_HEIGHT);
+	p->texture_count = double_buffered ? 2 : 1;
+	p->texture_dirty[0] = p->texture_dirty[1] = VIDEO_ALL_STRIPS;
+	p->present_needed = 1;
+	for (int i = 0; i < p->texture_count; ++i)
+		p->textures[i] = SDL_CreateTexture(p->renderer, SDL_PIXELFORMAT_ARGB8888,
+			SDL_TEXTUREACCESS_STREAMING, SCREEN_WIDTH * factor, SCREEN_HEIGHT * factor);
+	if (!p->window || !p->renderer || !p->textures[0] || (double_buffered && !p->textures[1])) {
+		platform_destroy(p);
+		return NULL;
+	}
+	SDL_RenderSetLogicalSize(p->renderer, SCREEN_WIDTH * factor, SCREEN_HEIGHT * factor);
 	{
 		SDL_AudioSpec desired;
 		SDL_zero(desired);
 		desired.freq = AUDIO_RATE;
 		desired.format = AUDIO_F32SYS;
 		desired.channels = 1;
-		desired.samples = 1024;
+		desired.samples = AUDIO_SAMPLES;
 		desired.callback = audio_callback;
 		desired.userdata = p;
 		p->noise_state = 0x8080u;
-		p->audio_device = SDL_OpenAudioDevice(NULL, 0, &desired, NULL, 0);
+		p->sound_events = soundqueue_create();
+		if (p->sound_events)
+			p->audio_device = SDL_OpenAudioDevice(NULL, 0, &desired, NULL, 0);
 		if (p->audio_device) SDL_PauseAudioDevice(p->audio_device, 0);
 	}
 	return p;
 }
 
-int platform_update(Platform *p, CPUState *state)
+int platform_poll(Platform *p, CPUState *state)
 {
 	SDL_Event event;
 	while (SDL_PollEvent(&event)) {
 		if (event.type == SDL_QUIT) return 0;
+		if (event.type == SDL_RENDER_TARGETS_RESET || event.type == SDL_RENDER_DEVICE_RESET) {
+			p->texture_dirty[0] = p->texture_dirty[1] = VIDEO_ALL_STRIPS;
+			p->present_needed = 1;
+		}
+		/* Exposed, resized, restored and the like: the window's contents
+		 * may be gone even though the frame hasn't changed. */
+		if (event.type == SDL_WINDOWEVENT) p->present_needed = 1;
 		if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE) return 0;
+		if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F2) p->reset_requested = 1;
+		if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F5) quick_save(p, state);
+		if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F9 && !p->loads_disabled) quick_load(p, state);
 		if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP)
 			set_control(p, state, event.key.keysym.sym, event.type == SDL_KEYDOWN);
 	}
@@ -190,28 +352,118 @@ int platform_update(Platform *p, CPUState *state)
 		if (p->coin_frames == 0)
 			state->input_ports[1] &= (uint8_t)~0x01;
 	}
-	update_sound(p, state);
-	for (int y = 0; y < SCREEN_HEIGHT; ++y) {
-		for (int x = 0; x < SCREEN_WIDTH; ++x) {
-			int source_bit = x * SCREEN_HEIGHT + (SCREEN_HEIGHT - 1 - y);
-			uint8_t byte = state->memory[VIDEO_RAM + source_bit / 8];
-			p->pixels[y * SCREEN_WIDTH + x] = (byte & (1u << (source_bit & 7))) ? 0xffffffff : 0xff000000;
+	return 1;
+}
+
+/* Finds the next run of strips set in mask from *strip on, leaving *strip
+ * just past it; returns the run's length, or 0 when there are none left. */
+static int next_run(uint32_t mask, int *strip)
+{
+	int first;
+	while (*strip < VIDEO_STRIPS && !(mask >> *strip & 1))
+		++*strip;
+	first = *strip;
+	while (*strip < VIDEO_STRIPS && (mask >> *strip & 1))
+		++*strip;
+	return *strip - first;
+}
+
+void platform_draw_vram(Platform *p, const uint8_t *vram, uint32_t dirty, uint32_t strips)
+{
+	int index = p->next_texture;
+	SDL_Texture *texture = p->textures[index];
+	uint32_t wanted;
+	int count;
+	/* Strips rewritten with the bytes they already had don't count, so an
+	 * unchanged frame goes unpresented. */
+	dirty = video_changed_strips(vram, p->shown_vram, dirty & strips);
+	if (dirty)
+		p->frame_changed = 1;
+	if (p->scaler) {
+		/* The scaler redraws the whole texture from this copy anyway. */
+		for (int strip = 0; (count = next_run(dirty, &strip)) > 0;)
+			video_convert_strips(vram, p->frame + (strip - count) * VIDEO_STRIP_COLUMNS,
+				SCREEN_WIDTH * (int)sizeof(uint32_t), strip - count, count);
+		return;
+	}
+	for (int i = 0; i < p->texture_count; ++i)
+		p->texture_dirty[i] |= dirty;
+	/* Each strip of the screen is one page of video memory, so only strips
+	 * changed since this texture was last drawn are converted, straight into
+	 * the locked texture one run at a time. */
+	wanted = p->texture_dirty[index] & strips;
+	for (int strip = 0; (count = next_run(wanted, &strip)) > 0;) {
+		int first = strip - count;
+		SDL_Rect rect;
+		void *pixels;
+		int pitch;
+		rect.x = first * VIDEO_STRIP_COLUMNS;
+		rect.y = 0;
+		rect.w = count * VIDEO_STRIP_COLUMNS;
+		rect.h = SCREEN_HEIGHT;
+		/* A run that can't be locked stays dirty for next time. */
+		if (SDL_LockTexture(texture, &rect, &pixels, &pitch) != 0)
+			continue;
+		video_convert_strips(vram, pixels, pitch, first, count);
+		SDL_UnlockTexture(texture);
+		p->texture_dirty[index] &= ~(VIDEO_ALL_STRIPS >> (VIDEO_STRIPS - count) << first);
+	}
+}
+
+void platform_present(Platform *p)
+{
+	int index = p->next_texture;
+	SDL_Texture *texture = p->textures[index];
+	if (!p->frame_changed && !p->present_needed)
+		return;
+	if (p->scaler) {
+		void *pixels;
+		int pitch;
+		/* A texture that can't be locked is stale on screen. */
+		p->present_needed = SDL_LockTexture(texture, NULL, &pixels, &pitch) != 0;
+		if (!p->present_needed) {
+			scaler_run(p->scaler, p->frame, SCREEN_WIDTH * (int)sizeof(uint32_t), pixels, pitch);
+			SDL_UnlockTexture(texture);
 		}
+	} else {
+		/* So is one left with strips it couldn't lock. */
+		p->present_needed = p->texture_dirty[index] != 0;
 	}
-	SDL_UpdateTexture(p->texture, NULL, p->pixels, SCREEN_WIDTH * (int)sizeof(uint32_t));
+	p->frame_changed = 0;
+	p->next_texture = (index + 1) % p->texture_count;
 	SDL_RenderClear(p->renderer);
-	SDL_RenderCopy(p->renderer, p->texture, NULL, NULL);
+	SDL_RenderCopy(p->renderer, texture, NULL, NULL);
 	SDL_RenderPresent(p->renderer);
-	return 1;
+}
+
+int platform_rewinding(Platform *p)
+{
+	return p->rewinding;
+}
+
+int platform_take_reset(Platform *p)
+{
+	int requested = p->reset_requested;
+	p->reset_requested = 0;
+	return requested;
+}
+
+void platform_disable_loads(Platform *p)
+{
+	p->loads_disabled = 1;
 }
 
 void platform_destroy(Platform *p)
 {
 	if (!p) return;
 	if (p->audio_device) SDL_CloseAudioDevice(p->audio_device);
-	if (p->texture) SDL_DestroyTexture(p->texture);
+	soundqueue_destroy(p->sound_events);
+	for (int i = 0; i < 2; ++i)
+		if (p->textures[i]) SDL_DestroyTexture(p->textures[i]);
 	if (p->renderer) SDL_DestroyRenderer(p->renderer);
 	if (p->window) SDL_DestroyWindow(p->window);
+	scaler_destroy(p->scaler);
+	free(p->frame);
 	SDL_Quit();
 	free(p);
 }
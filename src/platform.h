@@ -29,9 +29,42 @@
 #pragma once
 
 #include "cpu.h"
+#include "scale.h"
+#include "soundqueue.h"
+
+#include <stdint.h>
 
 typedef struct Platform Platform;
 
-Platform *platform_create(void);
-int platform_update(Platform *platform, CPUState *state);
+// Size of the platform's chunk in a save state
+#define PLATFORM_STATE_SIZE 96
+
+/* Opens the window; double_buffered alternates between two streaming
+ * textures so one can be written while the other may still be drawing.
+ * Unless filter is SCALE_NONE the screen is upscaled on the CPU, scale times
+ * for the filters that take a factor, split across scale_threads threads. */
+Platform *platform_create(int double_buffered, ScaleFilter filter, int scale, int scale_threads);
+/* Handles pending input and window events; returns 0 when the user quits. */
+int platform_poll(Platform *platform, CPUState *state);
+/* The queue the CPU's sound port writes should go to while it runs frames
+ * that are really played (see CPUState.sound_events), or NULL without audio. */
+SoundQueue *platform_sound_events(Platform *platform);
+/* Draws video memory, e.g. a copy taken from a frame queue, one part of the
+ * frame at a time: converts only the given strips, of which dirty marks the
+ * ones changed since they were last drawn, into the texture the next present
+ * shows. */
+void platform_draw_vram(Platform *platform, const uint8_t *vram, uint32_t dirty, uint32_t strips);
+/* Shows what platform_draw_vram() drew, unless nothing changed. */
+void platform_present(Platform *platform);
+/* Non-zero while the player holds the rewind key. */
+int platform_rewinding(Platform *platform);
+/* Non-zero once after the player asks for a reset. */
+int platform_take_reset(Platform *platform);
+/* Ignores the quick-load key, e.g. while a movie is being recorded. */
+void platform_disable_loads(Platform *platform);
 void platform_destroy(Platform *platform);
+
+/* Saves the sound voices and input pulse timing for a save state. */
+void platform_save_state(Platform *platform, uint8_t out[PLATFORM_STATE_SIZE]);
+/* Restores what platform_save_state() wrote; returns 0 on success. */
+int platform_load_state(Platform *platform, const uint8_t *in, uint32_t size);
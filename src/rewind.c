@@ -0,0 +1,175 @@
+/*******************************************************************************
+ * File: rewind.c
+ *
+ * Purpose:
+ *		A fixed-memory rewind buffer of per-frame snapshots.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#include "rewind.h"
+
+#include "snapshot.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct RewindEntry {
+	size_t offset; // Where the snapshot starts in the data ring
+	size_t size;
+	uint64_t keyframe; // Sequence number of the keyframe it was taken against
+} RewindEntry;
+
+struct RewindBuffer {
+	Snapshotter *snapshotter;
+	uint8_t *data; // Snapshots, stored back to back and wrapping at budget
+	size_t budget;
+	size_t write; // Where the next snapshot goes
+	RewindEntry *entries; // Indexed by sequence number modulo capacity
+	int capacity;
+	uint64_t oldest; // Sequence number of the oldest live snapshot
+	uint64_t next; // Sequence number the next snapshot gets
+	uint64_t keyframe; // Sequence number of the newest keyframe
+};
+
+#define ENTRY(rewind, sequence) (&(rewind)->entries[(sequence) % (uint64_t)(rewind)->capacity])
+
+// Creates a rewind buffer
+RewindBuffer *rewind_create(size_t budget_bytes, int max_frames, int keyframe_interval)
+{
+	RewindBuffer *rewind;
+	if (budget_bytes < 2 * snapshot_max_size() || max_frames < 2)
+		return NULL;
+	rewind = calloc(1, sizeof(RewindBuffer));
+	if (!rewind)
+		return NULL;
+	rewind->snapshotter = snapshot_create(keyframe_interval);
+	rewind->data = malloc(budget_bytes);
+	rewind->entries = calloc((size_t)max_frames, sizeof(RewindEntry));
+	if (!rewind->snapshotter || !rewind->data || !rewind->entries)
+	{
+		rewind_destroy(rewind);
+		return NULL;
+	}
+	// Touch the whole budget now so capturing never stalls on a page fault
+	memset(rewind->data, 0, budget_bytes);
+	rewind->budget = budget_bytes;
+	rewind->capacity = max_frames;
+	return rewind;
+}
+
+// Drops the oldest snapshot, along with any deltas it leaves without a keyframe
+static void drop_oldest(RewindBuffer *rewind)
+{
+	rewind->oldest++;
+	while (rewind->oldest < rewind->next && ENTRY(rewind, rewind->oldest)->keyframe < rewind->oldest)
+		rewind->oldest++;
+}
+
+// Frees a contiguous run of the ring big enough for any snapshot at write
+static void reserve(RewindBuffer *rewind)
+{
+	size_t needed = snapshot_max_size();
+	for (;;)
+	{
+		int live = rewind->oldest < rewind->next;
+		size_t oldest = live ? ENTRY(rewind, rewind->oldest)->offset : 0;
+		if (rewind->write + needed > rewind->budget)
+		{
+			// Whatever lies between here and the end must go before wrapping
+			if (live && oldest >= rewind->write)
+				drop_oldest(rewind);
+			else
+				rewind->write = 0;
+		}
+		else if (live && oldest >= rewind->write && oldest < rewind->write + needed)
+			drop_oldest(rewind);
+		else
+			return;
+	}
+}
+
+// Records a frame
+void rewind_capture(RewindBuffer *rewind, CPUState *state)
+{
+	RewindEntry *entry;
+	if (rewind->next - rewind->oldest >= (uint64_t)rewind->capacity)
+		drop_oldest(rewind);
+	reserve(rewind);
+	// Deltas are useless once the keyframe they'd be taken against is gone
+	if (rewind->keyframe < rewind->oldest)
+		snapshot_force_keyframe(rewind->snapshotter);
+
+	entry = ENTRY(rewind, rewind->next);
+	entry->offset = rewind->write;
+	entry->size = snapshot_capture(rewind->snapshotter, state, rewind->data + rewind->write);
+	if (snapshot_is_keyframe(rewind->data + entry->offset, entry->size))
+		rewind->keyframe = rewind->next;
+	entry->keyframe = rewind->keyframe;
+	rewind->write += entry->size;
+	rewind->next++;
+}
+
+// Steps back one frame
+int rewind_step(RewindBuffer *rewind, CPUState *state)
+{
+	RewindEntry *entry, *keyframe;
+	int more = rewind->next - rewind->oldest >= 2;
+	if (rewind->oldest == rewind->next)
+		return 0;
+	if (more)
+	{
+		// The newest snapshot is the frame on screen; reclaim it and show the one before
+		rewind->next--;
+		rewind->write = ENTRY(rewind, rewind->next)->offset;
+	}
+
+	entry = ENTRY(rewind, rewind->next - 1);
+	keyframe = ENTRY(rewind, entry->keyframe);
+	rewind->keyframe = entry->keyframe;
+	if (keyframe == entry)
+		snapshot_restore(state, rewind->data + entry->offset, entry->size, NULL, 0);
+	else
+		snapshot_restore(state, rewind->data + keyframe->offset, keyframe->size,
+			rewind->data + entry->offset, entry->size);
+	// Later deltas must not be taken against a keyframe that was reclaimed
+	snapshot_force_keyframe(rewind->snapshotter);
+	return more;
+}
+
+// Number of frames that can be rewound
+int rewind_frames(const RewindBuffer *rewind)
+{
+	return (int)(rewind->next - rewind->oldest);
+}
+
+// Releases a rewind buffer
+void rewind_destroy(RewindBuffer *rewind)
+{
+	if (!rewind)
+		return;
+	snapshot_destroy(rewind->snapshotter);
+	free(rewind->data);
+	free(rewind->entries);
+	free(rewind);
+}
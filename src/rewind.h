@@ -0,0 +1,65 @@
+/*******************************************************************************
+ * File: rewind.h
+ *
+ * Purpose:
+ *		Specification for the fixed-memory rewind buffer.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "cpu.h"
+
+#include <stddef.h>
+
+typedef struct RewindBuffer RewindBuffer;
+
+/**
+ * Creates a rewind buffer holding at most max_frames snapshots in a single
+ * allocation of budget_bytes. Snapshots are keyframes every keyframe_interval
+ * frames with page deltas in between. Returns NULL if the budget can't hold
+ * at least two keyframes.
+ */
+RewindBuffer *rewind_create(size_t budget_bytes, int max_frames, int keyframe_interval);
+
+/**
+ * Records the CPU state at the end of a frame, dropping the oldest frames
+ * when the buffer is full.
+ */
+void rewind_capture(RewindBuffer *rewind, CPUState *state);
+
+/**
+ * Steps the CPU state back by one recorded frame. Returns 0 once there is
+ * nothing older left to go back to.
+ */
+int rewind_step(RewindBuffer *rewind, CPUState *state);
+
+/**
+ * Number of frames that can currently be rewound.
+ */
+int rewind_frames(const RewindBuffer *rewind);
+
+/**
+ * Releases a rewind buffer.
+ */
+void rewind_destroy(RewindBuffer *rewind);
@@ -0,0 +1,242 @@
+/*******************************************************************************
+ * File: savestate.c
+ *
+ * Purpose:
+ *		The versioned binary save-state format.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS // Stop visual studio from complaining about insecure functions
+
+#include "savestate.h"
+
+#include "bytes.h"
+#include "memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const uint8_t magic[4] = { '8', '0', '8', '0' };
+
+// Size of a save state
+size_t savestate_size(uint32_t platform_size)
+{
+	size_t size = SAVESTATE_HEADER_SIZE +
+		SAVESTATE_CHUNK_HEADER_SIZE + SAVESTATE_CPU_SIZE +
+		SAVESTATE_CHUNK_HEADER_SIZE + MEMORY_SIZE;
+	if (platform_size)
+		size += SAVESTATE_CHUNK_HEADER_SIZE + platform_size;
+	return size;
+}
+
+// Encodes the registers and ports
+void savestate_write_cpu(CPUState *state, uint8_t out[SAVESTATE_CPU_SIZE])
+{
+	memset(out, 0, SAVESTATE_CPU_SIZE);
+	put_le16(out + 0, state->pc);
+	put_le16(out + 2, state->sp);
+	out[4] = state->a;
+	out[5] = state->b;
+	out[6] = state->c;
+	out[7] = state->d;
+	out[8] = state->e;
+	out[9] = state->h;
+	out[10] = state->l;
+	out[11] = encodeFlags(state);
+	out[12] = state->int_enable;
+	out[13] = state->halted;
+	memcpy(out + 14, state->input_ports, sizeof(state->input_ports));
+	memcpy(out + 18, state->output_ports, sizeof(state->output_ports));
+	put_le16(out + 26, state->shift_register);
+	out[28] = state->shift_offset;
+}
+
+// Checks the registers and ports can be decoded
+int savestate_check_cpu(const uint8_t in[SAVESTATE_CPU_SIZE])
+{
+	// in() shifts by 8 - shift_offset, which must stay in range
+	return in[28] > 7 ? -1 : 0;
+}
+
+// Decodes the registers and ports
+void savestate_read_cpu(CPUState *state, const uint8_t in[SAVESTATE_CPU_SIZE])
+{
+	state->pc = get_le16(in + 0);
+	state->sp = get_le16(in + 2);
+	state->a = in[4];
+	state->b = in[5];
+	state->c = in[6];
+	state->d = in[7];
+	state->e = in[8];
+	state->h = in[9];
+	state->l = in[10];
+	decodeFlags(state, in[11]);
+	state->int_enable = in[12];
+	state->halted = in[13];
+	memcpy(state->input_ports, in + 14, sizeof(state->input_ports));
+	memcpy(state->output_ports, in + 18, sizeof(state->output_ports));
+	state->shift_register = get_le16(in + 26);
+	state->shift_offset = in[28];
+}
+
+// Writes a save-state header
+void savestate_write_header(uint8_t *out, uint32_t chunk_count, uint32_t total_size)
+{
+	memcpy(out, magic, sizeof(magic));
+	put_le16(out + 4, SAVESTATE_VERSION);
+	put_le16(out + 6, SAVESTATE_HEADER_SIZE);
+	put_le32(out + 8, chunk_count);
+	put_le32(out + 12, total_size);
+}
+
+// Writes a chunk header
+uint8_t *savestate_write_chunk(uint8_t *out, uint32_t tag, uint32_t size)
+{
+	put_le32(out, tag);
+	put_le32(out + 4, size);
+	return out + SAVESTATE_CHUNK_HEADER_SIZE;
+}
+
+// Serializes a save state
+size_t savestate_write(CPUState *state, const uint8_t *platform, uint32_t platform_size,
+	uint8_t *out, size_t capacity)
+{
+	size_t size = savestate_size(platform_size);
+	uint8_t *cursor = out;
+	if (capacity < size)
+		return 0;
+
+	savestate_write_header(cursor, platform_size ? 3 : 2, (uint32_t)size);
+	cursor += SAVESTATE_HEADER_SIZE;
+
+	cursor = savestate_write_chunk(cursor, SAVESTATE_TAG_CPU, SAVESTATE_CPU_SIZE);
+	savestate_write_cpu(state, cursor);
+	cursor += SAVESTATE_CPU_SIZE;
+
+	cursor = savestate_write_chunk(cursor, SAVESTATE_TAG_MEMORY, MEMORY_SIZE);
+	memcpy(cursor, state->memory, MEMORY_SIZE);
+	cursor += MEMORY_SIZE;
+
+	if (platform_size)
+	{
+		cursor = savestate_write_chunk(cursor, SAVESTATE_TAG_PLATFORM, platform_size);
+		memcpy(cursor, platform, platform_size);
+	}
+	return size;
+}
+
+// Finds a chunk in a save-state buffer
+const uint8_t *savestate_find_chunk(const uint8_t *in, size_t size, uint32_t tag, uint32_t *length)
+{
+	size_t offset;
+	uint32_t chunks;
+
+	if (size < SAVESTATE_HEADER_SIZE || memcmp(in, magic, sizeof(magic)) != 0)
+		return NULL;
+	if (get_le16(in + 4) > SAVESTATE_VERSION || get_le16(in + 6) < SAVESTATE_HEADER_SIZE)
+		return NULL;
+	offset = get_le16(in + 6);
+	if (offset > size)
+		return NULL;
+	chunks = get_le32(in + 8);
+
+	for (uint32_t i = 0; i < chunks; ++i)
+	{
+		uint32_t chunk_tag, chunk_length;
+		if (size - offset < SAVESTATE_CHUNK_HEADER_SIZE)
+			return NULL;
+		chunk_tag = get_le32(in + offset);
+		chunk_length = get_le32(in + offset + 4);
+		offset += SAVESTATE_CHUNK_HEADER_SIZE;
+		if (size - offset < chunk_length)
+			return NULL;
+		if (chunk_tag == tag)
+		{
+			*length = chunk_length;
+			return in + offset;
+		}
+		offset += chunk_length;
+	}
+	return NULL;
+}
+
+// Restores a save state
+int savestate_read(CPUState *state, const uint8_t *in, size_t size,
+	const uint8_t **platform, uint32_t *platform_size)
+{
+	uint32_t cpu_length, memory_length, platform_length = 0;
+	const uint8_t *cpu = savestate_find_chunk(in, size, SAVESTATE_TAG_CPU, &cpu_length);
+	const uint8_t *memory = savestate_find_chunk(in, size, SAVESTATE_TAG_MEMORY, &memory_length);
+	const uint8_t *platform_chunk = savestate_find_chunk(in, size, SAVESTATE_TAG_PLATFORM, &platform_length);
+
+	if (!cpu || cpu_length < SAVESTATE_CPU_SIZE || savestate_check_cpu(cpu) != 0 ||
+		!memory || memory_length != MEMORY_SIZE)
+		return -1;
+
+	savestate_read_cpu(state, cpu);
+	memcpy(state->memory, memory, MEMORY_SIZE);
+	markAllPagesWritten(state);
+	if (platform)
+	{
+		*platform = platform_chunk;
+		*platform_size = platform_length;
+	}
+	return 0;
+}
+
+// Writes a buffer to a file
+int savestate_save_file(const char *path, const uint8_t *data, size_t size)
+{
+	FILE *f = fopen(path, "wb");
+	int ok;
+	if (f == NULL)
+		return -1;
+	ok = fwrite(data, 1, size, f) == size;
+	if (fclose(f) != 0)
+		ok = 0;
+	return ok ? 0 : -1;
+}
+
+// Reads a whole file into memory
+uint8_t *savestate_load_file(const char *path, size_t *size)
+{
+	FILE *f = fopen(path, "rb");
+	uint8_t *data;
+	long length;
+	if (f == NULL)
+		return NULL;
+	fseek(f, 0L, SEEK_END);
+	length = ftell(f);
+	fseek(f, 0L, SEEK_SET);
+	data = length > 0 ? malloc((size_t)length) : NULL;
+	if (!data || fread(data, 1, (size_t)length, f) != (size_t)length)
+	{
+		free(data);
+		fclose(f);
+		return NULL;
+	}
+	fclose(f);
+	*size = (size_t)length;
+	return data;
+}
@@ -0,0 +1,125 @@
+/*******************************************************************************
+ * File: savestate.h
+ *
+ * Purpose:
+ *		Specification for the versioned binary save-state format.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "cpu.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * A save state is a 16-byte header followed by tagged chunks, all
+ * little-endian:
+ *
+ *   header: "8080" magic, u16 version, u16 header size, u32 chunk count,
+ *           u32 total size
+ *   chunk:  u32 tag, u32 payload size, payload
+ *
+ * Readers skip chunks they don't know. Version 1 writes a "CPU " chunk with
+ * the registers and ports, a "MEM " chunk with the raw 64 KB address space and
+ * optionally a "PLAT" chunk owned by the platform layer (sound voices and
+ * input pulse timing).
+ */
+#define SAVESTATE_VERSION 1
+#define SAVESTATE_HEADER_SIZE 16
+#define SAVESTATE_CHUNK_HEADER_SIZE 8
+#define SAVESTATE_CPU_SIZE 32
+
+#define SAVESTATE_TAG(a, b, c, d) \
+	((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+#define SAVESTATE_TAG_CPU SAVESTATE_TAG('C', 'P', 'U', ' ')
+#define SAVESTATE_TAG_MEMORY SAVESTATE_TAG('M', 'E', 'M', ' ')
+#define SAVESTATE_TAG_PLATFORM SAVESTATE_TAG('P', 'L', 'A', 'T')
+
+/**
+ * Number of bytes savestate_write() needs for a state with a platform chunk
+ * of the given size (zero for none).
+ */
+size_t savestate_size(uint32_t platform_size);
+
+/**
+ * Serializes the CPU state, and the platform chunk if platform_size is
+ * non-zero. Returns the number of bytes written, or 0 if out is too small.
+ */
+size_t savestate_write(CPUState *state, const uint8_t *platform, uint32_t platform_size,
+	uint8_t *out, size_t capacity);
+
+/**
+ * Restores a CPU state from a buffer written by savestate_write(). The state
+ * is only modified if the buffer is valid. When platform is non-NULL it is
+ * pointed at the platform chunk inside the buffer (or NULL if there is none).
+ * Returns 0 on success, -1 if the buffer is malformed.
+ */
+int savestate_read(CPUState *state, const uint8_t *in, size_t size,
+	const uint8_t **platform, uint32_t *platform_size);
+
+/**
+ * Encodes just the registers and ports, as stored in the "CPU " chunk.
+ */
+void savestate_write_cpu(CPUState *state, uint8_t out[SAVESTATE_CPU_SIZE]);
+
+/**
+ * Returns 0 if a "CPU " chunk holds values the CPU can take, such as a shift
+ * offset below 8, or -1 if it came from a corrupt or foreign file.
+ */
+int savestate_check_cpu(const uint8_t in[SAVESTATE_CPU_SIZE]);
+
+/**
+ * Decodes registers and ports written by savestate_write_cpu(). The chunk
+ * must have passed savestate_check_cpu().
+ */
+void savestate_read_cpu(CPUState *state, const uint8_t in[SAVESTATE_CPU_SIZE]);
+
+/**
+ * Writes a save-state header for a buffer holding the given number of chunks.
+ */
+void savestate_write_header(uint8_t *out, uint32_t chunk_count, uint32_t total_size);
+
+/**
+ * Writes a chunk header and returns where its payload starts.
+ */
+uint8_t *savestate_write_chunk(uint8_t *out, uint32_t tag, uint32_t size);
+
+/**
+ * Finds the first chunk with the given tag in a save-state buffer. Returns its
+ * payload and stores its size in length, or returns NULL if the buffer is
+ * malformed or has no such chunk.
+ */
+const uint8_t *savestate_find_chunk(const uint8_t *in, size_t size, uint32_t tag, uint32_t *length);
+
+/**
+ * Writes a buffer to a file. Returns 0 on success, -1 on failure.
+ */
+int savestate_save_file(const char *path, const uint8_t *data, size_t size);
+
+/**
+ * Reads a whole file into a newly allocated buffer the caller frees. Returns
+ * NULL on failure.
+ */
+uint8_t *savestate_load_file(const char *path, size_t *size);
@@ -0,0 +1,658 @@
+/*******************************************************************************
+ * File: scale.c
+ *
+ * Purpose:
+ *		Implementation of the software upscaling filters.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#include "scale.h"
+
+#include "video.h"
+
+#include <SDL.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SCALE_SSE2
+#include <emmintrin.h>
+#endif
+
+// As in video.c: a build for AVX2 always uses it, and a plain x86 build with
+// GCC or Clang compiles the AVX2 rows for their own target and picks them at
+// run time when the CPU has AVX2.
+#if defined(__AVX2__)
+#define SCALE_AVX2
+#define SCALE_AVX2_TARGET
+#include <immintrin.h>
+#elif defined(SCALE_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define SCALE_AVX2
+#define SCALE_AVX2_DISPATCH
+#define SCALE_AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+typedef struct Worker {
+	Scaler *scaler;
+	SDL_Thread *thread;
+	int band;
+} Worker;
+
+struct Scaler {
+	ScaleFilter filter;
+	int factor;
+	int threads;
+	Worker workers[SCALE_MAX_THREADS];
+	SDL_mutex *lock;
+	SDL_cond *start; // Signalled when there's a new frame to scale
+	SDL_cond *done; // Signalled when the last band is finished
+	unsigned generation; // Frames handed out so far
+	int busy; // Workers still scaling this frame
+	int quit;
+	const uint32_t *src;
+	int src_pitch;
+	uint32_t *dst;
+	int dst_pitch;
+};
+
+static const char *filter_names[] = { "none", "nearest", "scale2x", "scale3x", "scanlines" };
+
+typedef void (*WidenRow)(const uint32_t *in, uint32_t *out, int factor);
+typedef void (*Scale2xRow)(const uint32_t *above, const uint32_t *row, const uint32_t *below,
+	uint32_t *out0, uint32_t *out1);
+typedef void (*Scale3xRow)(const uint32_t *above, const uint32_t *row, const uint32_t *below,
+	uint32_t *out0, uint32_t *out1, uint32_t *out2);
+
+// The fastest row functions the CPU runs, chosen on first use
+static WidenRow widen;
+static Scale2xRow scale2x;
+static Scale3xRow scale3x;
+static SDL_atomic_t rows_ready;
+
+// The pixel each output pixel of a widened row comes from, factor by factor:
+// lane k of the run of 8 * factor starting at pixel x takes pixel x + k / factor
+static int32_t widen_lanes[SCALE_MAX_FACTOR + 1][8 * SCALE_MAX_FACTOR];
+
+// Source row y, repeating the edge rows past the top and bottom
+static inline const uint32_t *src_row(const uint32_t *src, int pitch, int y)
+{
+	y = y < 0 ? 0 : y >= SCREEN_HEIGHT ? SCREEN_HEIGHT - 1 : y;
+	return (const uint32_t *)((const uint8_t *)src + (ptrdiff_t)y * pitch);
+}
+
+static inline uint32_t *dst_row(uint32_t *dst, int pitch, int y)
+{
+	return (uint32_t *)((uint8_t *)dst + (ptrdiff_t)y * pitch);
+}
+
+static inline uint32_t darken(uint32_t pixel)
+{
+	return ((pixel >> 1) & 0x007f7f7fu) | (pixel & 0xff000000u);
+}
+
+#if defined(SCALE_SSE2)
+
+static inline __m128i select128(__m128i mask, __m128i yes, __m128i no)
+{
+	return _mm_or_si128(_mm_and_si128(mask, yes), _mm_andnot_si128(mask, no));
+}
+
+// Interleaves a, b and c lane by lane into out[0..11]
+static inline void store3(uint32_t *out, __m128i a, __m128i b, __m128i c)
+{
+	__m128i ab_lo = _mm_unpacklo_epi32(a, b); // a0 b0 a1 b1
+	__m128i ab_hi = _mm_unpackhi_epi32(a, b); // a2 b2 a3 b3
+	__m128i bc_lo = _mm_unpacklo_epi32(b, c); // b0 c0 b1 c1
+	__m128i bc_hi = _mm_unpackhi_epi32(b, c); // b2 c2 b3 c3
+	__m128i ca_lo = _mm_shuffle_epi32(_mm_unpacklo_epi32(c, a), _MM_SHUFFLE(3, 0, 3, 0)); // c0 a1
+	__m128i ca_hi = _mm_shuffle_epi32(_mm_unpackhi_epi32(c, a), _MM_SHUFFLE(3, 0, 3, 0)); // c2 a3
+	_mm_storeu_si128((__m128i *)out, _mm_unpacklo_epi64(ab_lo, ca_lo));
+	_mm_storeu_si128((__m128i *)(out + 4), _mm_castpd_si128(_mm_shuffle_pd(
+		_mm_castsi128_pd(bc_lo), _mm_castsi128_pd(ab_hi), 1)));
+	_mm_storeu_si128((__m128i *)(out + 8), _mm_castpd_si128(_mm_shuffle_pd(
+		_mm_castsi128_pd(ca_hi), _mm_castsi128_pd(bc_hi), 2)));
+}
+
+#endif
+
+#if defined(SCALE_AVX2)
+
+SCALE_AVX2_TARGET static inline __m256i select256(__m256i mask, __m256i yes, __m256i no)
+{
+	return _mm256_blendv_epi8(no, yes, mask);
+}
+
+// Interleaves a and b lane by lane into out[0..15]
+SCALE_AVX2_TARGET static inline void store2_256(uint32_t *out, __m256i a, __m256i b)
+{
+	__m256i lo = _mm256_unpacklo_epi32(a, b);
+	__m256i hi = _mm256_unpackhi_epi32(a, b);
+	_mm256_storeu_si256((__m256i *)out, _mm256_permute2x128_si256(lo, hi, 0x20));
+	_mm256_storeu_si256((__m256i *)(out + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+// Interleaves a, b and c lane by lane into out[0..23]
+SCALE_AVX2_TARGET static inline void store3_256(uint32_t *out, __m256i a, __m256i b, __m256i c)
+{
+	store3(out, _mm256_castsi256_si128(a), _mm256_castsi256_si128(b), _mm256_castsi256_si128(c));
+	store3(out + 12, _mm256_extracti128_si256(a, 1), _mm256_extracti128_si256(b, 1),
+		_mm256_extracti128_si256(c, 1));
+}
+
+#endif
+
+// Repeats every pixel of a row factor times
+static void widen_row(const uint32_t *in, uint32_t *out, int factor)
+{
+	int x = 0;
+#if defined(SCALE_SSE2)
+	if (factor == 2)
+	{
+		for (; x + 4 <= SCREEN_WIDTH; x += 4)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i *)(in + x));
+			_mm_storeu_si128((__m128i *)(out + 2 * x), _mm_unpacklo_epi32(v, v));
+			_mm_storeu_si128((__m128i *)(out + 2 * x + 4), _mm_unpackhi_epi32(v, v));
+		}
+	}
+	else if (factor == 3)
+	{
+		for (; x + 4 <= SCREEN_WIDTH; x += 4)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i *)(in + x));
+			_mm_storeu_si128((__m128i *)(out + 3 * x), _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 0, 0)));
+			_mm_storeu_si128((__m128i *)(out + 3 * x + 4), _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 2, 1, 1)));
+			_mm_storeu_si128((__m128i *)(out + 3 * x + 8), _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 2)));
+		}
+	}
+	else if (factor == 4)
+	{
+		for (; x + 4 <= SCREEN_WIDTH; x += 4)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i *)(in + x));
+			_mm_storeu_si128((__m128i *)(out + 4 * x), _mm_shuffle_epi32(v, 0x00));
+			_mm_storeu_si128((__m128i *)(out + 4 * x + 4), _mm_shuffle_epi32(v, 0x55));
+			_mm_storeu_si128((__m128i *)(out + 4 * x + 8), _mm_shuffle_epi32(v, 0xaa));
+			_mm_storeu_si128((__m128i *)(out + 4 * x + 12), _mm_shuffle_epi32(v, 0xff));
+		}
+	}
+#endif
+	for (; x < SCREEN_WIDTH; ++x)
+		for (int i = 0; i < factor; ++i)
+			out[x * factor + i] = in[x];
+}
+
+#if defined(SCALE_AVX2)
+
+// Repeats every pixel of a row factor times, eight pixels in at a time
+SCALE_AVX2_TARGET static void widen_row_avx2(const uint32_t *in, uint32_t *out, int factor)
+{
+	const int32_t *lanes = widen_lanes[factor];
+	int x = 0;
+	// The SSE2 shuffles for 3 and 4 beat a permute per 8 pixels written.
+	if (factor == 3 || factor == 4)
+	{
+		widen_row(in, out, factor);
+		return;
+	}
+	for (; x + 8 <= SCREEN_WIDTH; x += 8)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i *)(in + x));
+		for (int j = 0; j < 8 * factor; j += 8)
+			_mm256_storeu_si256((__m256i *)(out + factor * x + j),
+				_mm256_permutevar8x32_epi32(v, _mm256_loadu_si256((const __m256i *)(lanes + j))));
+	}
+	for (; x < SCREEN_WIDTH; ++x)
+		for (int i = 0; i < factor; ++i)
+			out[x * factor + i] = in[x];
+}
+
+#endif
+
+// Halves the brightness of count pixels
+static void darken_row(uint32_t *row, int count)
+{
+	int x = 0;
+#if defined(SCALE_SSE2)
+	const __m128i colour = _mm_set1_epi32(0x007f7f7f);
+	const __m128i alpha = _mm_set1_epi32((int)0xff000000u);
+	for (; x + 4 <= count; x += 4)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)(row + x));
+		v = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 1), colour), _mm_and_si128(v, alpha));
+		_mm_storeu_si128((__m128i *)(row + x), v);
+	}
+#endif
+	for (; x < count; ++x)
+		row[x] = darken(row[x]);
+}
+
+static void nearest_rows(int factor, int scanlines, const uint32_t *src, int src_pitch,
+	uint32_t *dst, int dst_pitch, int first, int count)
+{
+	size_t width = (size_t)SCREEN_WIDTH * factor;
+	for (int y = first; y < first + count; ++y)
+	{
+		uint32_t *out = dst_row(dst, dst_pitch, y * factor);
+		widen(src_row(src, src_pitch, y), out, factor);
+		for (int i = 1; i < factor; ++i)
+			memcpy(dst_row(dst, dst_pitch, y * factor + i), out, width * sizeof(uint32_t));
+		if (scanlines)
+			darken_row(dst_row(dst, dst_pitch, y * factor + factor - 1), (int)width);
+	}
+}
+
+/*
+ * Scale2x: with A above P, B right, C left and D below, each corner of the
+ * 2x2 block takes the colour of the two neighbours it touches when they
+ * agree, unless the block sits on a straight edge (A == D or B == C).
+ */
+
+static inline void scale2x_pixel(const uint32_t *above, const uint32_t *row, const uint32_t *below,
+	uint32_t *out0, uint32_t *out1, int x)
+{
+	uint32_t a = above[x], d = below[x], p = row[x];
+	uint32_t c = row[x > 0 ? x - 1 : x], b = row[x < SCREEN_WIDTH - 1 ? x + 1 : x];
+	if (a != d && c != b)
+	{
+		out0[2 * x] = c == a ? a : p;
+		out0[2 * x + 1] = a == b ? b : p;
+		out1[2 * x] = c == d ? c : p;
+		out1[2 * x + 1] = d == b ? b : p;
+	}
+	else
+	{
+		out0[2 * x] = out0[2 * x + 1] = out1[2 * x] = out1[2 * x + 1] = p;
+	}
+}
+
+static void scale2x_row(const uint32_t *above, const uint32_t *row, const uint32_t *below,
+	uint32_t *out0, uint32_t *out1)
+{
+	int x = 1;
+	scale2x_pixel(above, row, below, out0, out1, 0);
+#if defined(SCALE_SSE2)
+	for (; x + 5 <= SCREEN_WIDTH; x += 4)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i *)(above + x));
+		__m128i d = _mm_loadu_si128((const __m128i *)(below + x));
+		__m128i p = _mm_loadu_si128((const __m128i *)(row + x));
+		__m128i c = _mm_loadu_si128((const __m128i *)(row + x - 1));
+		__m128i b = _mm_loadu_si128((const __m128i *)(row + x + 1));
+		__m128i k = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi32(a, d), _mm_cmpeq_epi32(c, b)),
+			_mm_set1_epi32(-1));
+		__m128i e0 = select128(_mm_and_si128(k, _mm_cmpeq_epi32(c, a)), a, p);
+		__m128i e1 = select128(_mm_and_si128(k, _mm_cmpeq_epi32(a, b)), b, p);
+		__m128i e2 = select128(_mm_and_si128(k, _mm_cmpeq_epi32(c, d)), c, p);
+		__m128i e3 = select128(_mm_and_si128(k, _mm_cmpeq_epi32(d, b)), b, p);
+		_mm_storeu_si128((__m128i *)(out0 + 2 * x), _mm_unpacklo_epi32(e0, e1));
+		_mm_storeu_si128((__m128i *)(out0 + 2 * x + 4), _mm_unpackhi_epi32(e0, e1));
+		_mm_storeu_si128((__m128i *)(out1 + 2 * x), _mm_unpacklo_epi32(e2, e3));
+		_mm_storeu_si128((__m128i *)(out1 + 2 * x + 4), _mm_unpackhi_epi32(e2, e3));
+	}
+#endif
+	for (; x < SCREEN_WIDTH; ++x)
+		scale2x_pixel(above, row, below, out0, out1, x);
+}
+
+#if defined(SCALE_AVX2)
+
+SCALE_AVX2_TARGET static void scale2x_row_avx2(const uint32_t *above, const uint32_t *row, const uint32_t *below,
+	uint32_t *out0, uint32_t *out1)
+{
+	int x = 1;
+	scale2x_pixel(above, row, below, out0, out1, 0);
+	for (; x + 9 <= SCREEN_WIDTH; x += 8)
+	{
+		__m256i a = _mm256_loadu_si256((const __m256i *)(above + x));
+		__m256i d = _mm256_loadu_si256((const __m256i *)(below + x));
+		__m256i p = _mm256_loadu_si256((const __m256i *)(row + x));
+		__m256i c = _mm256_loadu_si256((const __m256i *)(row + x - 1));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(row + x + 1));
+		__m256i k = _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpeq_epi32(a, d), _mm256_cmpeq_epi32(c, b)),
+			_mm256_set1_epi32(-1));
+		store2_256(out0 + 2 * x,
+			select256(_mm256_and_si256(k, _mm256_cmpeq_epi32(c, a)), a, p),
+			select256(_mm256_and_si256(k, _mm256_cmpeq_epi32(a, b)), b, p));
+		store2_256(out1 + 2 * x,
+			select256(_mm256_and_si256(k, _mm256_cmpeq_epi32(c, d)), c, p),
+			select256(_mm256_and_si256(k, _mm256_cmpeq_epi32(d, b)), b, p));
+	}
+	for (; x < SCREEN_WIDTH; ++x)
+		scale2x_pixel(above, row, below, out0, out1, x);
+}
+
+#endif
+
+/*
+ * Scale3x: the same idea over the 3x3 neighbourhood
+ *     A B C
+ *     D E F
+ *     G H I
+ * where edge pixels also need the diagonal to differ so that corners of
+ * solid shapes stay square.
+ */
+
+static inline void scale3x_pixel(const uint32_t *above, const uint32_t *row, const uint32_t *below,
+	uint32_t *out0, uint32_t *out1, uint32_t *out2, int x)
+{
+	int l = x > 0 ? x - 1 : x, r = x < SCREEN_WIDTH - 1 ? x + 1 : x;
+	uint32_t a = above[l], b = above[x], c = above[r];
+	uint32_t d = row[l], e = row[x], f = row[r];
+	uint32_t g = below[l], h = below[x], i = below[r];
+	uint32_t *o0 = out0 + 3 * x, *o1 = out1 + 3 * x, *o2 = out2 + 3 * x;
+	if (b != h && d != f)
+	{
+		o0[0] = d == b ? d : e;
+		o0[1] = (d == b && e != c) || (b == f && e != a) ? b : e;
+		o0[2] = b == f ? f : e;
+		o1[0] = (d == b && e != g) || (d == h && e != a) ? d : e;
+		o1[1] = e;
+		o1[2] = (b == f && e != i) || (h == f && e != c) ? f : e;
+		o2[0] = d == h ? d : e;
+		o2[1] = (d == h && e != i) || (h == f && e != g) ? h : e;
+		o2[2] = h == f ? f : e;
+	}
+	else
+	{
+		o0[0] = o0[1] = o0[2] = o1[0] = o1[1] = o1[2] = o2[0] = o2[1] = o2[2] = e;
+	}
+}
+
+static void scale3x_row(const uint32_t *above, const uint32_t *row, const uint32_t *below,
+	uint32_t *out0, uint32_t *out1, uint32_t *out2)
+{
+	int x = 1;
+	scale3x_pixel(above, row, below, out0, out1, out2, 0);
+#if defined(SCALE_SSE2)
+	for (; x + 5 <= SCREEN_WIDTH; x += 4)
+	{
+#define LOAD(p) _mm_loadu_si128((const __m128i *)(p))
+		__m128i a = LOAD(above + x - 1), b = LOAD(above + x), c = LOAD(above + x + 1);
+		__m128i d = LOAD(row + x - 1), e = LOAD(row + x), f = LOAD(row + x + 1);
+		__m128i g = LOAD(below + x - 1), h = LOAD(below + x), i = LOAD(below + x + 1);
+#undef LOAD
+		__m128i k = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi32(b, h), _mm_cmpeq_epi32(d, f)),
+			_mm_set1_epi32(-1));
+		__m128i db = _mm_and_si128(k, _mm_cmpeq_epi32(d, b));
+		__m128i bf = _mm_and_si128(k, _mm_cmpeq_epi32(b, f));
+		__m128i dh = _mm_and_si128(k, _mm_cmpeq_epi32(d, h));
+		__m128i hf = _mm_and_si128(k, _mm_cmpeq_epi32(h, f));
+		__m128i ea = _mm_cmpeq_epi32(e, a), ec = _mm_cmpeq_epi32(e, c);
+		__m128i eg = _mm_cmpeq_epi32(e, g), ei = _mm_cmpeq_epi32(e, i);
+		store3(out0 + 3 * x,
+			select128(db, d, e),
+			select128(_mm_or_si128(_mm_andnot_si128(ec, db), _mm_andnot_si128(ea, bf)), b, e),
+			select128(bf, f, e));
+		store3(out1 + 3 * x,
+			select128(_mm_or_si128(_mm_andnot_si128(eg, db), _mm_andnot_si128(ea, dh)), d, e),
+			e,
+			select128(_mm_or_si128(_mm_andnot_si128(ei, bf), _mm_andnot_si128(ec, hf)), f, e));
+		store3(out2 + 3 * x,
+			select128(dh, d, e),
+			select128(_mm_or_si128(_mm_andnot_si128(ei, dh), _mm_andnot_si128(eg, hf)), h, e),
+			select128(hf, f, e));
+	}
+#endif
+	for (; x < SCREEN_WIDTH; ++x)
+		scale3x_pixel(above, row, below, out0, out1, out2, x);
+}
+
+#if defined(SCALE_AVX2)
+
+SCALE_AVX2_TARGET static void scale3x_row_avx2(const uint32_t *above, const uint32_t *row, const uint32_t *below,
+	uint32_t *out0, uint32_t *out1, uint32_t *out2)
+{
+	int x = 1;
+	scale3x_pixel(above, row, below, out0, out1, out2, 0);
+	for (; x + 9 <= SCREEN_WIDTH; x += 8)
+	{
+#define LOAD(p) _mm256_loadu_si256((const __m256i *)(p))
+		__m256i a = LOAD(above + x - 1), b = LOAD(above + x), c = LOAD(above + x + 1);
+		__m256i d = LOAD(row + x - 1), e = LOAD(row + x), f = LOAD(row + x + 1);
+		__m256i g = LOAD(below + x - 1), h = LOAD(below + x), i = LOAD(below + x + 1);
+#undef LOAD
+		__m256i k = _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpeq_epi32(b, h), _mm256_cmpeq_epi32(d, f)),
+			_mm256_set1_epi32(-1));
+		__m256i db = _mm256_and_si256(k, _mm256_cmpeq_epi32(d, b));
+		__m256i bf = _mm256_and_si256(k, _mm256_cmpeq_epi32(b, f));
+		__m256i dh = _mm256_and_si256(k, _mm256_cmpeq_epi32(d, h));
+		__m256i hf = _mm256_and_si256(k, _mm256_cmpeq_epi32(h, f));
+		__m256i ea = _mm256_cmpeq_epi32(e, a), ec = _mm256_cmpeq_epi32(e, c);
+		__m256i eg = _mm256_cmpeq_epi32(e, g), ei = _mm256_cmpeq_epi32(e, i);
+		store3_256(out0 + 3 * x,
+			select256(db, d, e),
+			select256(_mm256_or_si256(_mm256_andnot_si256(ec, db), _mm256_andnot_si256(ea, bf)), b, e),
+			select256(bf, f, e));
+		store3_256(out1 + 3 * x,
+			select256(_mm256_or_si256(_mm256_andnot_si256(eg, db), _mm256_andnot_si256(ea, dh)), d, e),
+			e,
+			select256(_mm256_or_si256(_mm256_andnot_si256(ei, bf), _mm256_andnot_si256(ec, hf)), f, e));
+		store3_256(out2 + 3 * x,
+			select256(dh, d, e),
+			select256(_mm256_or_si256(_mm256_andnot_si256(ei, dh), _mm256_andnot_si256(eg, hf)), h, e),
+			select256(hf, f, e));
+	}
+	for (; x < SCREEN_WIDTH; ++x)
+		scale3x_pixel(above, row, below, out0, out1, out2, x);
+}
+
+#endif
+
+// Picks the row functions for the CPU
+static void pick_rows(void)
+{
+	for (int factor = 1; factor <= SCALE_MAX_FACTOR; ++factor)
+		for (int k = 0; k < 8 * factor; ++k)
+			widen_lanes[factor][k] = k / factor;
+	widen = widen_row;
+	scale2x = scale2x_row;
+	scale3x = scale3x_row;
+#if defined(SCALE_AVX2_DISPATCH)
+	if (SDL_HasAVX2())
+#endif
+#if defined(SCALE_AVX2)
+	{
+		widen = widen_row_avx2;
+		scale2x = scale2x_row_avx2;
+		scale3x = scale3x_row_avx2;
+	}
+#endif
+	SDL_AtomicSet(&rows_ready, 1);
+}
+
+// Parses a filter name
+int scale_parse_filter(const char *name)
+{
+	for (int filter = 0; filter < (int)(sizeof(filter_names) / sizeof(filter_names[0])); ++filter)
+	{
+		if (strcmp(name, filter_names[filter]) == 0)
+			return filter;
+	}
+	return -1;
+}
+
+// Finds the factor a filter really scales by
+int scale_factor(ScaleFilter filter, int factor)
+{
+	int least = filter == SCALE_SCANLINES ? 2 : 1;
+	switch (filter)
+	{
+	case SCALE_SCALE2X:
+		return 2;
+	case SCALE_SCALE3X:
+		return 3;
+	default:
+		return factor < least ? least : factor > SCALE_MAX_FACTOR ? SCALE_MAX_FACTOR : factor;
+	}
+}
+
+// Scales a band of rows
+void scale_rows(ScaleFilter filter, int factor, const uint32_t *src, int src_pitch,
+	uint32_t *dst, int dst_pitch, int first, int count)
+{
+	factor = scale_factor(filter, factor);
+	if (!SDL_AtomicGet(&rows_ready))
+		pick_rows();
+	switch (filter)
+	{
+	case SCALE_SCALE2X:
+		for (int y = first; y < first + count; ++y)
+			scale2x(src_row(src, src_pitch, y - 1), src_row(src, src_pitch, y),
+				src_row(src, src_pitch, y + 1),
+				dst_row(dst, dst_pitch, 2 * y), dst_row(dst, dst_pitch, 2 * y + 1));
+		break;
+	case SCALE_SCALE3X:
+		for (int y = first; y < first + count; ++y)
+			scale3x(src_row(src, src_pitch, y - 1), src_row(src, src_pitch, y),
+				src_row(src, src_pitch, y + 1), dst_row(dst, dst_pitch, 3 * y),
+				dst_row(dst, dst_pitch, 3 * y + 1), dst_row(dst, dst_pitch, 3 * y + 2));
+		break;
+	default:
+		nearest_rows(factor, filter == SCALE_SCANLINES, src, src_pitch, dst, dst_pitch, first, count);
+		break;
+	}
+}
+
+// Scales one band of the current frame
+static void scale_band(Scaler *scaler, int band)
+{
+	int first = SCREEN_HEIGHT * band / scaler->threads;
+	int end = SCREEN_HEIGHT * (band + 1) / scaler->threads;
+	scale_rows(scaler->filter, scaler->factor, scaler->src, scaler->src_pitch,
+		scaler->dst, scaler->dst_pitch, first, end - first);
+}
+
+// Scales a band of every frame handed out until told to quit
+static int worker_main(void *data)
+{
+	Worker *worker = data;
+	Scaler *scaler = worker->scaler;
+	unsigned seen = 0;
+	SDL_LockMutex(scaler->lock);
+	for (;;)
+	{
+		while (!scaler->quit && scaler->generation == seen)
+			SDL_CondWait(scaler->start, scaler->lock);
+		if (scaler->quit)
+			break;
+		seen = scaler->generation;
+		SDL_UnlockMutex(scaler->lock);
+		scale_band(scaler, worker->band);
+		SDL_LockMutex(scaler->lock);
+		if (--scaler->busy == 0)
+			SDL_CondSignal(scaler->done);
+	}
+	SDL_UnlockMutex(scaler->lock);
+	return 0;
+}
+
+// Creates a scaler
+Scaler *scaler_create(ScaleFilter filter, int factor, int threads)
+{
+	Scaler *scaler;
+	if (filter == SCALE_NONE)
+		return NULL;
+	scaler = calloc(1, sizeof(Scaler));
+	if (!scaler)
+		return NULL;
+	scaler->filter = filter;
+	scaler->factor = scale_factor(filter, factor);
+	scaler->threads = 1;
+	if (threads > 1)
+	{
+		scaler->lock = SDL_CreateMutex();
+		scaler->start = SDL_CreateCond();
+		scaler->done = SDL_CreateCond();
+		if (!scaler->lock || !scaler->start || !scaler->done)
+			threads = 1;
+	}
+	// Band 0 is the caller's; a worker that can't be started just means
+	// fewer, wider bands.
+	for (int band = 1; band < threads && band < SCALE_MAX_THREADS; ++band)
+	{
+		Worker *worker = &scaler->workers[band];
+		worker->scaler = scaler;
+		worker->band = band;
+		worker->thread = SDL_CreateThread(worker_main, "scaler", worker);
+		if (!worker->thread)
+			break;
+		scaler->threads = band + 1;
+	}
+	return scaler;
+}
+
+// Scales the whole screen across the bands
+void scaler_run(Scaler *scaler, const uint32_t *src, int src_pitch, uint32_t *dst, int dst_pitch)
+{
+	scaler->src = src;
+	scaler->src_pitch = src_pitch;
+	scaler->dst = dst;
+	scaler->dst_pitch = dst_pitch;
+	if (scaler->threads == 1)
+	{
+		scale_band(scaler, 0);
+		return;
+	}
+	SDL_LockMutex(scaler->lock);
+	scaler->busy = scaler->threads - 1;
+	++scaler->generation;
+	SDL_CondBroadcast(scaler->start);
+	SDL_UnlockMutex(scaler->lock);
+	scale_band(scaler, 0);
+	SDL_LockMutex(scaler->lock);
+	while (scaler->busy > 0)
+		SDL_CondWait(scaler->done, scaler->lock);
+	SDL_UnlockMutex(scaler->lock);
+}
+
+// Reports the scaler's factor
+int scaler_factor(Scaler *scaler)
+{
+	return scaler->factor;
+}
+
+// Releases a scaler
+void scaler_destroy(Scaler *scaler)
+{
+	if (!scaler)
+		return;
+	if (scaler->lock)
+	{
+		SDL_LockMutex(scaler->lock);
+		scaler->quit = 1;
+		SDL_CondBroadcast(scaler->start);
+		SDL_UnlockMutex(scaler->lock);
+	}
+	for (int band = 1; band < scaler->threads; ++band)
+		SDL_WaitThread(scaler->workers[band].thread, NULL);
+	if (scaler->done)
+		SDL_DestroyCond(scaler->done);
+	if (scaler->start)
+		SDL_DestroyCond(scaler->start);
+	if (scaler->lock)
+		SDL_DestroyMutex(scaler->lock);
+	free(scaler);
+}
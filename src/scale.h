@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * File: scale.h
+ *
+ * Purpose:
+ *		Specification for the software upscaling filters.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Upscales the converted screen on the CPU so the window's texture can be
+ * copied 1:1, which keeps the software renderer fast and gives the same look
+ * on every renderer. The source is SCREEN_WIDTH x SCREEN_HEIGHT ARGB8888
+ * pixels; the destination is factor times that in each direction.
+ */
+typedef enum ScaleFilter {
+	SCALE_NONE, // Leave scaling to the renderer
+	SCALE_NEAREST, // Each pixel becomes a factor x factor block
+	SCALE_SCALE2X, // Scale2x edge smoothing, always 2x
+	SCALE_SCALE3X, // Scale3x edge smoothing, always 3x
+	SCALE_SCANLINES // Nearest, with the last row of each block at half brightness
+} ScaleFilter;
+
+#define SCALE_MAX_FACTOR 8
+#define SCALE_MAX_THREADS 8
+
+typedef struct Scaler Scaler;
+
+/**
+ * Parses a filter name ("none", "nearest", "scale2x", "scale3x" or
+ * "scanlines"). Returns -1 if the name isn't one of them.
+ */
+int scale_parse_filter(const char *name);
+
+/**
+ * Returns the factor a filter scales by: fixed for Scale2x and Scale3x,
+ * otherwise factor clamped to 1..SCALE_MAX_FACTOR (2..SCALE_MAX_FACTOR for
+ * scanlines, which need a row to darken).
+ */
+int scale_factor(ScaleFilter filter, int factor);
+
+/**
+ * Scales source rows first to first + count - 1 into their rows of dst. src
+ * must hold the whole screen, since the edge-smoothing filters look at the
+ * rows either side.
+ */
+void scale_rows(ScaleFilter filter, int factor, const uint32_t *src, int src_pitch,
+	uint32_t *dst, int dst_pitch, int first, int count);
+
+/**
+ * Creates a scaler that splits the screen into bands of rows across threads
+ * threads, counting the caller's. Returns NULL for SCALE_NONE.
+ */
+Scaler *scaler_create(ScaleFilter filter, int factor, int threads);
+
+/**
+ * Scales the whole screen, returning once every band is done.
+ */
+void scaler_run(Scaler *scaler, const uint32_t *src, int src_pitch, uint32_t *dst, int dst_pitch);
+
+/**
+ * Returns the factor the scaler scales by.
+ */
+int scaler_factor(Scaler *scaler);
+
+/**
+ * Stops the scaler's threads and releases it.
+ */
+void scaler_destroy(Scaler *scaler);
@@ -0,0 +1,263 @@
+/*******************************************************************************
+ * File: shmring.c
+ *
+ * Purpose:
+ *		Implementation of the shared-memory frame ring.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#include "shmring.h"
+
+#include <stdio.h>
+
+#ifdef _WIN32
+
+ShmRing *shmring_create(const char *name)
+{
+	fprintf(stderr, "Shared-memory frames aren't supported on Windows\n");
+	return NULL;
+}
+
+void shmring_publish(ShmRing *ring, const uint8_t *vram)
+{
+}
+
+ShmRing *shmring_attach(const char *name)
+{
+	return NULL;
+}
+
+const uint8_t *shmring_latest(ShmRing *ring, uint32_t *frame, uint32_t *token)
+{
+	return NULL;
+}
+
+int shmring_still_valid(ShmRing *ring, uint32_t frame, uint32_t token)
+{
+	return 0;
+}
+
+void shmring_destroy(ShmRing *ring)
+{
+}
+
+#else
+
+#include "video.h"
+
+#include <SDL.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MAGIC "8080SHM1"
+#define HEADER_SIZE 64
+#define SLOT_HEADER_SIZE 64
+#define SLOT_SIZE (SLOT_HEADER_SIZE + VIDEO_BYTES)
+#define RING_SIZE (HEADER_SIZE + SHMRING_SLOTS * SLOT_SIZE)
+
+typedef struct Header {
+	char magic[8];
+	uint32_t slots;
+	uint32_t slot_size;
+	uint32_t frame_bytes;
+	SDL_atomic_t published;
+} Header;
+
+typedef struct Slot {
+	SDL_atomic_t sequence;
+	uint32_t frame;
+} Slot;
+
+struct ShmRing {
+	uint8_t *base;
+	size_t size; // Bytes mapped
+	uint32_t slots; // As the header gives them, for the reading end
+	uint32_t slot_size;
+	char *name; // Set for the writing end, which removes the object
+	uint32_t next; // Frame the writing end publishes next
+};
+
+static Header *header(ShmRing *ring)
+{
+	return (Header *)ring->base;
+}
+
+static Slot *slot(ShmRing *ring, uint32_t frame)
+{
+	return (Slot *)(ring->base + HEADER_SIZE + (size_t)(frame % ring->slots) * ring->slot_size);
+}
+
+// Creates the writing end
+ShmRing *shmring_create(const char *name)
+{
+	ShmRing *ring = calloc(1, sizeof(ShmRing));
+	// Refuse to share a name with another writer, which would interleave
+	// frames and remove the object from under it on exit.
+	int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+	void *base = MAP_FAILED;
+	Header *h;
+	if (fd < 0 && errno == EEXIST)
+		fprintf(stderr, "Shared memory %s already exists; another emulator may be using it\n", name);
+	else if (fd < 0)
+		fprintf(stderr, "Unable to create shared memory %s\n", name);
+	if (ring && fd >= 0 && ftruncate(fd, RING_SIZE) == 0)
+		base = mmap(NULL, RING_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (fd >= 0)
+	{
+		close(fd);
+		if (base == MAP_FAILED)
+		{
+			fprintf(stderr, "Unable to map shared memory %s\n", name);
+			shm_unlink(name);
+		}
+	}
+	if (base == MAP_FAILED)
+	{
+		free(ring);
+		return NULL;
+	}
+	ring->base = base;
+	ring->size = RING_SIZE;
+	ring->slots = SHMRING_SLOTS;
+	ring->slot_size = SLOT_SIZE;
+	ring->name = malloc(strlen(name) + 1);
+	if (ring->name)
+		strcpy(ring->name, name);
+	h = header(ring);
+	memset(ring->base, 0, RING_SIZE);
+	h->slots = SHMRING_SLOTS;
+	h->slot_size = SLOT_SIZE;
+	h->frame_bytes = VIDEO_BYTES;
+	// The magic goes in last so a reader never sees a half-made header.
+	SDL_MemoryBarrierRelease();
+	memcpy(h->magic, MAGIC, sizeof(h->magic));
+	return ring;
+}
+
+// Publishes a frame
+void shmring_publish(ShmRing *ring, const uint8_t *vram)
+{
+	Slot *s = slot(ring, ring->next);
+	int sequence = SDL_AtomicGet(&s->sequence);
+	SDL_AtomicSet(&s->sequence, sequence + 1);
+	SDL_MemoryBarrierRelease();
+	s->frame = ring->next;
+	memcpy((uint8_t *)s + SLOT_HEADER_SIZE, vram, VIDEO_BYTES);
+	SDL_MemoryBarrierRelease();
+	SDL_AtomicSet(&s->sequence, sequence + 2);
+	SDL_AtomicSet(&header(ring)->published, (int)++ring->next);
+}
+
+// Maps a ring for reading
+ShmRing *shmring_attach(const char *name)
+{
+	ShmRing *ring = calloc(1, sizeof(ShmRing));
+	int fd = shm_open(name, O_RDONLY, 0);
+	struct stat st;
+	const Header *h;
+	if (!ring || fd < 0 || fstat(fd, &st) != 0)
+	{
+		fprintf(stderr, "Unable to open shared memory %s\n", name);
+		if (fd >= 0)
+			close(fd);
+		free(ring);
+		return NULL;
+	}
+	// Reading past the end of the object would raise SIGBUS, so everything
+	// the header promises has to fit in what is actually there.
+	ring->size = (size_t)st.st_size;
+	if (st.st_size >= HEADER_SIZE)
+		ring->base = mmap(NULL, ring->size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (!ring->base || ring->base == MAP_FAILED)
+	{
+		fprintf(stderr, "%s is not a frame ring\n", name);
+		free(ring);
+		return NULL;
+	}
+	h = header(ring);
+	ring->slots = h->slots;
+	ring->slot_size = h->slot_size;
+	if (memcmp(h->magic, MAGIC, sizeof(h->magic)) != 0 || h->frame_bytes != VIDEO_BYTES ||
+		ring->slots == 0 || ring->slot_size < SLOT_HEADER_SIZE + VIDEO_BYTES ||
+		(uint64_t)ring->slots * ring->slot_size > ring->size - HEADER_SIZE)
+	{
+		fprintf(stderr, "%s is not a frame ring\n", name);
+		shmring_destroy(ring);
+		return NULL;
+	}
+	return ring;
+}
+
+// The mapping is read-only, so the reader loads the counters directly rather
+// than through SDL's atomics, which may fall back to read-modify-write.
+static uint32_t load_counter(const SDL_atomic_t *counter)
+{
+	uint32_t value = (uint32_t)*(const volatile int *)&counter->value;
+	SDL_MemoryBarrierAcquire();
+	return value;
+}
+
+// Views the newest frame
+const uint8_t *shmring_latest(ShmRing *ring, uint32_t *frame, uint32_t *token)
+{
+	uint32_t published = load_counter(&header(ring)->published);
+	uint32_t back;
+	// If the newest slot is already being overwritten by the next frame, the
+	// one before it is still whole.
+	for (back = 1; back <= 2 && back <= published; ++back)
+	{
+		Slot *s = slot(ring, published - back);
+		*token = load_counter(&s->sequence);
+		*frame = s->frame;
+		if (!(*token & 1) && *frame == published - back)
+			return (const uint8_t *)s + SLOT_HEADER_SIZE;
+	}
+	return NULL;
+}
+
+// Checks a view is still intact
+int shmring_still_valid(ShmRing *ring, uint32_t frame, uint32_t token)
+{
+	SDL_MemoryBarrierAcquire();
+	return load_counter(&slot(ring, frame)->sequence) == token;
+}
+
+// Unmaps a ring
+void shmring_destroy(ShmRing *ring)
+{
+	if (!ring)
+		return;
+	munmap(ring->base, ring->size);
+	if (ring->name)
+		shm_unlink(ring->name);
+	free(ring->name);
+	free(ring);
+}
+
+#endif
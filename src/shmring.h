@@ -0,0 +1,94 @@
+/*******************************************************************************
+ * File: shmring.h
+ *
+ * Purpose:
+ *		Specification for the shared-memory frame ring.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Publishes every finished frame's video memory to a POSIX shared-memory
+ * object so other processes can watch the live screen without sockets or
+ * pipes. The object starts with a 64-byte header:
+ *
+ *     char     magic[8]     "8080SHM1"
+ *     uint32_t slots        frames kept, SHMRING_SLOTS when written here
+ *     uint32_t slot_size    bytes from one slot to the next
+ *     uint32_t frame_bytes  VIDEO_BYTES
+ *     uint32_t published    frames published so far, updated last
+ *
+ * followed by the slots. Frame n goes in slot n % slots, which holds a 32-bit
+ * sequence number, the frame number, and at offset 64 the raw 1bpp video
+ * memory in the machine's rotated layout. The sequence number is odd while
+ * the slot is being written: a reader notes it, reads the frame in place,
+ * then checks it hasn't changed (a seqlock). Readers take the slot count and
+ * size from the header rather than assuming them.
+ *
+ * tools/shmwatch.c is a small reader that reports the frames it sees.
+ *
+ * Not available on Windows.
+ */
+typedef struct ShmRing ShmRing;
+
+#define SHMRING_SLOTS 8
+
+/**
+ * Creates the shared-memory object name (e.g. "/invaders") and returns the
+ * writing end, or NULL with a message if it can't be created. The name must
+ * not be in use already, so two emulators can't share a ring by mistake.
+ */
+ShmRing *shmring_create(const char *name);
+
+/**
+ * Publishes the video memory of a finished frame.
+ */
+void shmring_publish(ShmRing *ring, const uint8_t *vram);
+
+/**
+ * Maps an existing ring read-only, for a consumer, or returns NULL with a
+ * message if the object is missing or isn't a whole frame ring.
+ */
+ShmRing *shmring_attach(const char *name);
+
+/**
+ * Returns a view of the newest frame, storing its number in frame and a token
+ * for shmring_still_valid() in token; NULL if there is no frame yet or the
+ * writer has lapped the reader.
+ */
+const uint8_t *shmring_latest(ShmRing *ring, uint32_t *frame, uint32_t *token);
+
+/**
+ * Tells whether a view from shmring_latest() was left alone while it was
+ * read; if not, whatever was read from it may be torn.
+ */
+int shmring_still_valid(ShmRing *ring, uint32_t frame, uint32_t token);
+
+/**
+ * Unmaps the ring, and removes the shared-memory object if this is the
+ * writing end.
+ */
+void shmring_destroy(ShmRing *ring);
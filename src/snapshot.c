@@ -0,0 +1,315 @@
+/*******************************************************************************
+ * File: snapshot.c
+ *
+ * Purpose:
+ *		Incremental snapshots of the CPU state.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#include "snapshot.h"
+
+#include "bytes.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+struct Snapshotter {
+	uint8_t keyframe[MEMORY_SIZE]; // Memory as of the last keyframe
+	uint32_t keyframe_epoch; // Write epoch started when it was taken
+	uint32_t keyframe_id;
+	int keyframe_interval;
+	int until_keyframe;
+};
+
+#define KEYFRAME_SIZE (SAVESTATE_HEADER_SIZE + \
+	SAVESTATE_CHUNK_HEADER_SIZE + SAVESTATE_CPU_SIZE + \
+	SAVESTATE_CHUNK_HEADER_SIZE + MEMORY_SIZE + \
+	SAVESTATE_CHUNK_HEADER_SIZE + 4)
+
+// Creates a snapshotter
+Snapshotter *snapshot_create(int keyframe_interval)
+{
+	Snapshotter *snapshotter = calloc(1, sizeof(Snapshotter));
+	if (!snapshotter)
+		return NULL;
+	snapshotter->keyframe_interval = keyframe_interval > 0 ? keyframe_interval : 1;
+	return snapshotter;
+}
+
+// Size of the largest snapshot
+size_t snapshot_max_size(void)
+{
+	return KEYFRAME_SIZE;
+}
+
+// Writes a keyframe and makes it the base for later deltas
+static size_t capture_keyframe(Snapshotter *snapshotter, CPUState *state, uint8_t *out)
+{
+	uint8_t *cursor = out;
+
+	snapshotter->keyframe_id++;
+	snapshotter->keyframe_epoch = beginWriteEpoch(state);
+	snapshotter->until_keyframe = snapshotter->keyframe_interval;
+	memcpy(snapshotter->keyframe, state->memory, MEMORY_SIZE);
+
+	savestate_write_header(cursor, 3, KEYFRAME_SIZE);
+	cursor += SAVESTATE_HEADER_SIZE;
+	cursor = savestate_write_chunk(cursor, SAVESTATE_TAG_CPU, SAVESTATE_CPU_SIZE);
+	savestate_write_cpu(state, cursor);
+	cursor += SAVESTATE_CPU_SIZE;
+	cursor = savestate_write_chunk(cursor, SAVESTATE_TAG_MEMORY, MEMORY_SIZE);
+	memcpy(cursor, snapshotter->keyframe, MEMORY_SIZE);
+	cursor += MEMORY_SIZE;
+	cursor = savestate_write_chunk(cursor, SNAPSHOT_TAG_KEYFRAME, 4);
+	put_le32(cursor, snapshotter->keyframe_id);
+	return KEYFRAME_SIZE;
+}
+
+// Run-length encodes the XOR of a page against its keyframe copy. Trailing
+// equal bytes are left implicit. Returns the encoded size.
+static size_t encode_page(const uint8_t *page, const uint8_t *keyframe, uint8_t *out)
+{
+	size_t i = 0, length = 0, end = MEMORY_PAGE_SIZE;
+
+	while (end > 0 && page[end - 1] == keyframe[end - 1])
+		end--;
+	while (i < end)
+	{
+		size_t equal = 0, literal = 0;
+		while (i < end && page[i] == keyframe[i] && equal < 255)
+		{
+			equal++;
+			i++;
+		}
+		out[length++] = (uint8_t)equal;
+		while (i + literal < end && page[i + literal] != keyframe[i + literal] && literal < 255)
+			literal++;
+		out[length++] = (uint8_t)literal;
+		for (size_t k = 0; k < literal; ++k)
+			out[length++] = page[i + k] ^ keyframe[i + k];
+		i += literal;
+	}
+	return length;
+}
+
+// Applies an encoded page on top of its keyframe copy, or with page NULL
+// just checks the encoding
+static int decode_page(uint8_t *page, const uint8_t *in, size_t length)
+{
+	size_t i = 0, offset = 0;
+	while (offset + 2 <= length)
+	{
+		size_t literal = in[offset + 1];
+		i += in[offset];
+		offset += 2;
+		if (i + literal > MEMORY_PAGE_SIZE || offset + literal > length)
+			return -1;
+		for (size_t k = 0; page && k < literal; ++k)
+			page[i + k] ^= in[offset + k];
+		i += literal;
+		offset += literal;
+	}
+	return offset == length ? 0 : -1;
+}
+
+// Applies a delta's page records to memory, or with memory NULL just checks
+// that every record is whole and well formed
+static int decode_pages(uint8_t *memory, const uint8_t *pages, uint32_t pages_length)
+{
+	size_t offset;
+	for (offset = 4; offset + 3 <= pages_length;)
+	{
+		uint8_t *page = memory ? memory + ((size_t)pages[offset] << MEMORY_PAGE_SHIFT) : NULL;
+		size_t length = get_le16(pages + offset + 1);
+		offset += 3;
+		if (offset + length > pages_length || decode_page(page, pages + offset, length) != 0)
+			return -1;
+		offset += length;
+	}
+	return 0;
+}
+
+// Captures a snapshot
+size_t snapshot_capture(Snapshotter *snapshotter, CPUState *state, uint8_t *out)
+{
+	uint8_t *cursor, *pages;
+	// Leave room for one worst-case page so encoding never overruns
+	const size_t limit = KEYFRAME_SIZE - (3 + MEMORY_PAGE_SIZE * 3 / 2);
+	size_t size;
+
+	if (snapshotter->until_keyframe <= 0)
+		return capture_keyframe(snapshotter, state, out);
+	snapshotter->until_keyframe--;
+
+	cursor = out + SAVESTATE_HEADER_SIZE;
+	cursor = savestate_write_chunk(cursor, SAVESTATE_TAG_CPU, SAVESTATE_CPU_SIZE);
+	savestate_write_cpu(state, cursor);
+	cursor += SAVESTATE_CPU_SIZE;
+	pages = cursor + SAVESTATE_CHUNK_HEADER_SIZE;
+	cursor = pages;
+	put_le32(cursor, snapshotter->keyframe_id);
+	cursor += 4;
+
+	for (int page = 0; page < MEMORY_PAGES; ++page)
+	{
+		size_t offset = (size_t)page << MEMORY_PAGE_SHIFT;
+		size_t length;
+		if (!pageWrittenSince(state, page, snapshotter->keyframe_epoch))
+			continue;
+		length = encode_page(state->memory + offset, snapshotter->keyframe + offset, cursor + 3);
+		if (length == 0)
+			continue;
+		cursor[0] = (uint8_t)page;
+		put_le16(cursor + 1, (uint16_t)length);
+		cursor += 3 + length;
+		if ((size_t)(cursor - out) > limit)
+			return capture_keyframe(snapshotter, state, out);
+	}
+
+	savestate_write_chunk(pages - SAVESTATE_CHUNK_HEADER_SIZE, SNAPSHOT_TAG_PAGES, (uint32_t)(cursor - pages));
+	size = (size_t)(cursor - out);
+	savestate_write_header(out, 2, (uint32_t)size);
+	return size;
+}
+
+// Makes the next capture a keyframe
+void snapshot_force_keyframe(Snapshotter *snapshotter)
+{
+	snapshotter->until_keyframe = 0;
+}
+
+// Tests whether a snapshot is a keyframe
+int snapshot_is_keyframe(const uint8_t *snapshot, size_t size)
+{
+	uint32_t length;
+	return savestate_find_chunk(snapshot, size, SNAPSHOT_TAG_KEYFRAME, &length) != NULL;
+}
+
+// Restores a keyframe and optionally a delta
+int snapshot_restore(CPUState *state, const uint8_t *keyframe, size_t keyframe_size,
+	const uint8_t *delta, size_t delta_size)
+{
+	uint32_t id_length, cpu_length, pages_length;
+	const uint8_t *id = savestate_find_chunk(keyframe, keyframe_size, SNAPSHOT_TAG_KEYFRAME, &id_length);
+	const uint8_t *cpu = NULL, *pages = NULL;
+
+	if (!id || id_length < 4)
+		return -1;
+	if (delta)
+	{
+		cpu = savestate_find_chunk(delta, delta_size, SAVESTATE_TAG_CPU, &cpu_length);
+		pages = savestate_find_chunk(delta, delta_size, SNAPSHOT_TAG_PAGES, &pages_length);
+		if (!cpu || cpu_length < SAVESTATE_CPU_SIZE || savestate_check_cpu(cpu) != 0 ||
+			!pages || pages_length < 4 || get_le32(pages) != get_le32(id) ||
+			decode_pages(NULL, pages, pages_length) != 0)
+			return -1;
+	}
+	// Like savestate_read(), which changes nothing unless the keyframe is
+	// valid, the delta is checked whole above so it can't fail halfway.
+	if (savestate_read(state, keyframe, keyframe_size, NULL, NULL) != 0)
+		return -1;
+	if (!delta)
+		return 0;
+
+	savestate_read_cpu(state, cpu);
+	decode_pages(state->memory, pages, pages_length);
+	return 0;
+}
+
+// Releases a snapshotter
+void snapshot_destroy(Snapshotter *snapshotter)
+{
+	free(snapshotter);
+}
+
+struct GoldenSnapshot {
+	uint8_t memory[MEMORY_SIZE];
+	uint8_t cpu[SAVESTATE_CPU_SIZE];
+	CPUState *last; // State whose pages since mark are the only ones that can differ
+	uint32_t mark;
+};
+
+// Captures a golden snapshot
+GoldenSnapshot *golden_capture(CPUState *state)
+{
+	GoldenSnapshot *golden = malloc(sizeof(GoldenSnapshot));
+	if (!golden)
+		return NULL;
+	memcpy(golden->memory, state->memory, MEMORY_SIZE);
+	savestate_write_cpu(state, golden->cpu);
+	golden->last = state;
+	golden->mark = beginWriteEpoch(state);
+	return golden;
+}
+
+// Brings a golden snapshot up to date with the state
+void golden_refresh(GoldenSnapshot *golden, CPUState *state)
+{
+	savestate_write_cpu(state, golden->cpu);
+	if (golden->last != state)
+	{
+		memcpy(golden->memory, state->memory, MEMORY_SIZE);
+	}
+	else
+	{
+		for (int page = 0; page < MEMORY_PAGES; ++page)
+		{
+			size_t offset = (size_t)page << MEMORY_PAGE_SHIFT;
+			if (pageWrittenSince(state, page, golden->mark))
+				memcpy(golden->memory + offset, state->memory + offset, MEMORY_PAGE_SIZE);
+		}
+	}
+	golden->last = state;
+	golden->mark = beginWriteEpoch(state);
+}
+
+// Resets to a golden snapshot
+void golden_restore(GoldenSnapshot *golden, CPUState *state)
+{
+	savestate_read_cpu(state, golden->cpu);
+	if (golden->last != state)
+	{
+		memcpy(state->memory, golden->memory, MEMORY_SIZE);
+		markAllPagesWritten(state);
+	}
+	else
+	{
+		for (int page = 0; page < MEMORY_PAGES; ++page)
+		{
+			size_t offset = (size_t)page << MEMORY_PAGE_SHIFT;
+			if (!pageWrittenSince(state, page, golden->mark))
+				continue;
+			memcpy(state->memory + offset, golden->memory + offset, MEMORY_PAGE_SIZE);
+			// Still a write as far as anyone else tracking pages is concerned
+			state->page_written[page] = state->write_epoch;
+		}
+	}
+	golden->last = state;
+	golden->mark = beginWriteEpoch(state);
+}
+
+// Releases a golden snapshot
+void golden_destroy(GoldenSnapshot *golden)
+{
+	free(golden);
+}
@@ -0,0 +1,124 @@
+/*******************************************************************************
+ * File: snapshot.h
+ *
+ * Purpose:
+ *		Specification for incremental snapshots of the CPU state.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "cpu.h"
+#include "savestate.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Snapshots are save-state buffers of two kinds:
+ *
+ *   keyframe: the usual "CPU " and "MEM " chunks plus a "KEY " chunk holding
+ *             the keyframe's sequence number.
+ *   delta:    a "CPU " chunk and a "PAGE" chunk holding, for each memory page
+ *             that differs from the keyframe, the page number and the XOR of
+ *             the two pages run-length encoded as (equal run, literal run,
+ *             literal bytes) triples.
+ *
+ * A delta always describes the machine relative to its keyframe rather than
+ * to the previous delta, so restoring any snapshot costs at most one keyframe
+ * copy and one delta.
+ */
+#define SNAPSHOT_TAG_KEYFRAME SAVESTATE_TAG('K', 'E', 'Y', ' ')
+#define SNAPSHOT_TAG_PAGES SAVESTATE_TAG('P', 'A', 'G', 'E')
+
+typedef struct Snapshotter Snapshotter;
+
+/**
+ * Creates a snapshotter that writes a keyframe at least every
+ * keyframe_interval snapshots.
+ */
+Snapshotter *snapshot_create(int keyframe_interval);
+
+/**
+ * Size of the largest snapshot snapshot_capture() can produce.
+ */
+size_t snapshot_max_size(void);
+
+/**
+ * Captures the CPU state into out, which must hold snapshot_max_size() bytes.
+ * Pages are only compared if they were written since the keyframe; a delta
+ * that would grow larger than a keyframe is replaced by one. Returns the
+ * number of bytes written.
+ */
+size_t snapshot_capture(Snapshotter *snapshotter, CPUState *state, uint8_t *out);
+
+/**
+ * Makes the next capture a keyframe, e.g. after the machine was restored.
+ */
+void snapshot_force_keyframe(Snapshotter *snapshotter);
+
+/**
+ * Tests whether a snapshot is a keyframe.
+ */
+int snapshot_is_keyframe(const uint8_t *snapshot, size_t size);
+
+/**
+ * Restores a keyframe, then applies a delta taken against it if delta is
+ * non-NULL. Returns 0 on success, -1 if either buffer is malformed or the
+ * delta belongs to a different keyframe, in which case state is unchanged.
+ */
+int snapshot_restore(CPUState *state, const uint8_t *keyframe, size_t keyframe_size,
+	const uint8_t *delta, size_t delta_size);
+
+/**
+ * Releases a snapshotter.
+ */
+void snapshot_destroy(Snapshotter *snapshotter);
+
+typedef struct GoldenSnapshot GoldenSnapshot;
+
+/**
+ * Captures a full copy of the CPU state to reset to later, typically once the
+ * machine has finished booting.
+ */
+GoldenSnapshot *golden_capture(CPUState *state);
+
+/**
+ * Recaptures the CPU state into an existing golden copy, copying only the
+ * pages written since the last capture or restore when it is the same state.
+ * Together with golden_restore() this makes a cheap save point for running a
+ * few frames speculatively.
+ */
+void golden_refresh(GoldenSnapshot *golden, CPUState *state);
+
+/**
+ * Puts the CPU state back to the golden copy. When the state is the one the
+ * golden copy was last captured from or restored into, only the pages written
+ * since then are copied back.
+ */
+void golden_restore(GoldenSnapshot *golden, CPUState *state);
+
+/**
+ * Releases a golden snapshot.
+ */
+void golden_destroy(GoldenSnapshot *golden);
@@ -0,0 +1,95 @@
+/*******************************************************************************
+ * File: soundqueue.c
+ *
+ * Purpose:
+ *		Hands sound port writes from the emulation thread to the audio callback.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#include "soundqueue.h"
+
+#include "frame.h"
+
+#include <SDL.h>
+#include <stdlib.h>
+
+struct SoundQueue {
+	SoundEvent events[SOUNDQUEUE_EVENTS];
+	SDL_atomic_t head; // Events popped so far, written by the consumer
+	SDL_atomic_t tail; // Events pushed so far, written by the producer
+	uint64_t frame_start; // Instructions before the current frame, producer only
+	uint8_t queued[2]; // Last values pushed for ports 3 and 5, producer only
+};
+
+// Creates a sound queue
+SoundQueue *soundqueue_create(void)
+{
+	return calloc(1, sizeof(SoundQueue));
+}
+
+// Appends an event unless it repeats the last value queued for the port
+int soundqueue_push(SoundQueue *queue, int instruction, uint8_t port, uint8_t value)
+{
+	unsigned tail = (unsigned)SDL_AtomicGet(&queue->tail);
+	uint8_t *queued = &queue->queued[port == 3 ? 0 : 1];
+	SoundEvent *event;
+	if (*queued == value)
+		return 1;
+	if (tail - (unsigned)SDL_AtomicGet(&queue->head) >= SOUNDQUEUE_EVENTS)
+		return 0;
+	event = &queue->events[tail % SOUNDQUEUE_EVENTS];
+	event->time = queue->frame_start + (uint64_t)instruction;
+	event->port = port;
+	event->value = value;
+	*queued = value;
+	// Publishing the new tail is what hands the event over.
+	SDL_AtomicSet(&queue->tail, (int)(tail + 1));
+	return 1;
+}
+
+// Starts the next frame
+void soundqueue_end_frame(SoundQueue *queue)
+{
+	queue->frame_start += FRAME_INSTRUCTIONS;
+}
+
+// Looks at the oldest event
+const SoundEvent *soundqueue_peek(SoundQueue *queue)
+{
+	unsigned head = (unsigned)SDL_AtomicGet(&queue->head);
+	if (head == (unsigned)SDL_AtomicGet(&queue->tail))
+		return NULL;
+	return &queue->events[head % SOUNDQUEUE_EVENTS];
+}
+
+// Drops the oldest event
+void soundqueue_pop(SoundQueue *queue)
+{
+	SDL_AtomicSet(&queue->head, SDL_AtomicGet(&queue->head) + 1);
+}
+
+// Releases a sound queue
+void soundqueue_destroy(SoundQueue *queue)
+{
+	free(queue);
+}
@@ -0,0 +1,85 @@
+/*******************************************************************************
+ * File: soundqueue.h
+ *
+ * Purpose:
+ *		Hands sound port writes from the emulation thread to the audio callback.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Carries writes to the sound ports from the thread running the CPU to the
+ * audio callback without either ever taking a lock: a fixed ring of events
+ * with one index advanced by each side. Each event is stamped with the
+ * instruction it happened at, counted across the frames the queue has seen,
+ * so the callback can start a sound on the sample where it belongs rather
+ * than at the next frame boundary.
+ */
+typedef struct SoundQueue SoundQueue;
+
+typedef struct SoundEvent {
+	uint64_t time; // Instructions run before the port was written
+	uint8_t port;
+	uint8_t value;
+} SoundEvent;
+
+/* Events the ring holds; a frame writes the sound ports a handful of times. */
+#define SOUNDQUEUE_EVENTS 256
+
+/**
+ * Creates an empty sound queue.
+ */
+SoundQueue *soundqueue_create(void);
+
+/**
+ * Appends an event for a write of port 3 or 5 at the given instruction of the
+ * current frame, or drops it and returns 0 if the ring is full. A value equal
+ * to the last one queued for the port changes nothing and isn't queued. Only
+ * one thread may push.
+ */
+int soundqueue_push(SoundQueue *queue, int instruction, uint8_t port, uint8_t value);
+
+/**
+ * Moves the queue's clock on to the next frame. The pushing thread calls it
+ * after each frame it ran with the queue attached.
+ */
+void soundqueue_end_frame(SoundQueue *queue);
+
+/**
+ * Returns the oldest event not yet popped, or NULL if there is none. It stays
+ * valid until soundqueue_pop(). Only one thread may peek and pop.
+ */
+const SoundEvent *soundqueue_peek(SoundQueue *queue);
+
+/**
+ * Drops the event soundqueue_peek() returned.
+ */
+void soundqueue_pop(SoundQueue *queue);
+
+/**
+ * Releases a sound queue.
+ */
+void soundqueue_destroy(SoundQueue *queue);
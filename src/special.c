@@ -28,10 +28,16 @@
 
 #include "special.h"
 
+#include "soundqueue.h"
+
  // OUT
 void out(CPUState *state)
 {
 	uint8_t port = state->memory[state->pc];
+	// Ports 3 and 5 drive the sound board; the games rewrite them far more
+	// often than they change them, so the queue keeps only the changes.
+	if ((port == 3 || port == 5) && state->sound_events)
+		soundqueue_push(state->sound_events, state->frame_instruction, port, state->a);
 	if (port < sizeof(state->output_ports))
 		state->output_ports[port] = state->a;
 	if (port == 2)
@@ -0,0 +1,255 @@
+/*******************************************************************************
+ * File: video.c
+ *
+ * Purpose:
+ *		Implementation of turning the video memory into pixels.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#include "video.h"
+
+#include "memory.h"
+
+#include <SDL.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VIDEO_SSE2
+#include <emmintrin.h>
+#endif
+
+// A build for AVX2 always uses it. A plain x86 build with GCC or Clang also
+// compiles the AVX2 converter, for its own target, and picks it at run time
+// when the CPU has AVX2.
+#if defined(__AVX2__)
+#define VIDEO_AVX2
+#define VIDEO_AVX2_TARGET
+#include <immintrin.h>
+#elif defined(VIDEO_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define VIDEO_AVX2
+#define VIDEO_AVX2_DISPATCH
+#define VIDEO_AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+/*
+ * Within a strip, the bytes at the same height in the 8 columns form an 8x8
+ * block of pixels; transposing its bits yields 8 bytes that each hold 8
+ * horizontally adjacent pixels, and a lookup table expands each of those to
+ * 8 ARGB values.
+ */
+
+typedef void (*ConvertStrip)(const uint8_t *column, uint8_t *pixels, ptrdiff_t pitch, int x, int strip);
+
+// Eight pixels for every byte, lowest bit leftmost
+static uint32_t expand[256][8];
+static SDL_atomic_t expand_ready;
+
+// The fastest converter the CPU runs, chosen along with the table
+static ConvertStrip convert_strip;
+
+// What each 8 pixels of each row are ANDed with, white to show them as they
+// are; stored strip by strip so converting a strip reads it in order
+static uint32_t tint[VIDEO_STRIPS][SCREEN_HEIGHT];
+static int overlay_ready;
+
+static void build_expand(void);
+
+// Writes 8 pixels for bit `bit` of the bytes at height `k` of a strip. Lit
+// pixels are white and dark ones opaque black, so ANDing with the overlay
+// colour tints the one and leaves the other.
+static inline void put_row(uint8_t *pixels, ptrdiff_t pitch, int x, int strip, int k, int bit, unsigned row)
+{
+	int y = SCREEN_HEIGHT - 1 - 8 * k - bit;
+	uint8_t *out = pixels + (ptrdiff_t)y * pitch + x * sizeof(uint32_t);
+	const uint32_t *in = expand[row & 0xff];
+	uint32_t colour = tint[strip][y];
+#if defined(VIDEO_SSE2)
+	__m128i tint = _mm_set1_epi32((int)colour);
+	_mm_storeu_si128((__m128i *)out, _mm_and_si128(_mm_loadu_si128((const __m128i *)in), tint));
+	_mm_storeu_si128((__m128i *)out + 1, _mm_and_si128(_mm_loadu_si128((const __m128i *)in + 1), tint));
+#else
+	uint32_t tinted[8];
+	for (int i = 0; i < 8; ++i)
+		tinted[i] = in[i] & colour;
+	memcpy(out, tinted, sizeof(tinted));
+#endif
+}
+
+#if defined(VIDEO_AVX2)
+
+// Transposes four blocks at a time: movemask collects the top bit of every
+// byte, after which each byte is shifted up to expose the next bit.
+VIDEO_AVX2_TARGET static void convert_strip_avx2(const uint8_t *column, uint8_t *pixels, ptrdiff_t pitch, int x, int strip)
+{
+	const __m256i gather = _mm256_setr_epi8(
+		0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+		0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+	const __m256i interleave = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+	for (int k = 0; k < VIDEO_COLUMN_BYTES; k += 4)
+	{
+		uint32_t words[8];
+		__m256i bytes;
+		for (int c = 0; c < 8; ++c)
+			memcpy(&words[c], column + c * VIDEO_COLUMN_BYTES + k, sizeof(words[c]));
+		// Byte 4c + j holds height k + j of column c; regroup it to 8j + c.
+		bytes = _mm256_loadu_si256((const __m256i *)words);
+		bytes = _mm256_shuffle_epi8(bytes, gather);
+		bytes = _mm256_permutevar8x32_epi32(bytes, interleave);
+		for (int bit = 7; bit >= 0; --bit)
+		{
+			uint32_t rows = (uint32_t)_mm256_movemask_epi8(bytes);
+			for (int j = 0; j < 4; ++j)
+				put_row(pixels, pitch, x, strip, k + j, bit, rows >> (8 * j));
+			bytes = _mm256_add_epi8(bytes, bytes);
+		}
+	}
+}
+
+#endif
+
+#if defined(VIDEO_SSE2) && (!defined(VIDEO_AVX2) || defined(VIDEO_AVX2_DISPATCH))
+
+// Transposes two blocks at a time: movemask collects the top bit of every
+// byte, after which each byte is shifted up to expose the next bit.
+static void convert_strip_sse2(const uint8_t *column, uint8_t *pixels, ptrdiff_t pitch, int x, int strip)
+{
+	const __m128i low = _mm_set1_epi16(0xff);
+
+	for (int k = 0; k < VIDEO_COLUMN_BYTES; k += 2)
+	{
+		uint16_t words[8];
+		__m128i pairs, bytes;
+		for (int c = 0; c < 8; ++c)
+			memcpy(&words[c], column + c * VIDEO_COLUMN_BYTES + k, sizeof(words[c]));
+		// Split each column's pair so heights k and k + 1 fill one half each.
+		pairs = _mm_loadu_si128((const __m128i *)words);
+		bytes = _mm_packus_epi16(_mm_and_si128(pairs, low), _mm_srli_epi16(pairs, 8));
+		for (int bit = 7; bit >= 0; --bit)
+		{
+			unsigned rows = (unsigned)_mm_movemask_epi8(bytes);
+			put_row(pixels, pitch, x, strip, k, bit, rows);
+			put_row(pixels, pitch, x, strip, k + 1, bit, rows >> 8);
+			bytes = _mm_add_epi8(bytes, bytes);
+		}
+	}
+}
+
+#elif !defined(VIDEO_SSE2)
+
+// Transposes one block at a time in a 64-bit word (Hacker's Delight 7-3):
+// bit b of byte c swaps places with bit c of byte b.
+static void convert_strip_scalar(const uint8_t *column, uint8_t *pixels, ptrdiff_t pitch, int x, int strip)
+{
+	for (int k = 0; k < VIDEO_COLUMN_BYTES; ++k)
+	{
+		uint64_t block = 0, t;
+		for (int c = 0; c < 8; ++c)
+			block |= (uint64_t)column[c * VIDEO_COLUMN_BYTES + k] << (8 * c);
+		t = (block ^ (block >> 7)) & 0x00aa00aa00aa00aaull;
+		block ^= t ^ (t << 7);
+		t = (block ^ (block >> 14)) & 0x0000cccc0000ccccull;
+		block ^= t ^ (t << 14);
+		t = (block ^ (block >> 28)) & 0x00000000f0f0f0f0ull;
+		block ^= t ^ (t << 28);
+		for (int bit = 0; bit < 8; ++bit)
+			put_row(pixels, pitch, x, strip, k, bit, (unsigned)(block >> (8 * bit)));
+	}
+}
+
+#endif
+
+// Fills in the table and picks the converter
+static void build_expand(void)
+{
+	for (int byte = 0; byte < 256; ++byte)
+		for (int bit = 0; bit < 8; ++bit)
+			expand[byte][bit] = (byte & (1 << bit)) ? VIDEO_WHITE : VIDEO_BLACK;
+	if (!overlay_ready)
+		video_set_overlay(NULL);
+#if defined(VIDEO_AVX2_DISPATCH)
+	convert_strip = SDL_HasAVX2() ? convert_strip_avx2 : convert_strip_sse2;
+#elif defined(VIDEO_AVX2)
+	convert_strip = convert_strip_avx2;
+#elif defined(VIDEO_SSE2)
+	convert_strip = convert_strip_sse2;
+#else
+	convert_strip = convert_strip_scalar;
+#endif
+	SDL_AtomicSet(&expand_ready, 1);
+}
+
+// Sets the colours lit pixels are shown in
+void video_set_overlay(const VideoOverlay *colours)
+{
+	for (int y = 0; y < SCREEN_HEIGHT; ++y)
+		for (int strip = 0; strip < VIDEO_STRIPS; ++strip)
+			tint[strip][y] = colours ? colours->colour[y][strip] : VIDEO_WHITE;
+	overlay_ready = 1;
+}
+
+// Finds the strips written since a mark
+uint32_t video_dirty_strips(CPUState *state, uint32_t *mark)
+{
+	uint32_t dirty = 0;
+	for (int strip = 0; strip < VIDEO_STRIPS; ++strip)
+	{
+		if (pageWrittenSince(state, (VIDEO_RAM >> MEMORY_PAGE_SHIFT) + strip, *mark))
+			dirty |= 1u << strip;
+	}
+	*mark = beginWriteEpoch(state);
+	return dirty;
+}
+
+// Drops the dirty strips whose bytes are unchanged
+uint32_t video_changed_strips(const uint8_t *vram, uint8_t *previous, uint32_t dirty)
+{
+	uint32_t changed = 0;
+	for (int strip = 0; strip < VIDEO_STRIPS; ++strip)
+	{
+		size_t offset = (size_t)strip * VIDEO_STRIP_BYTES;
+		if (!(dirty >> strip & 1) || memcmp(vram + offset, previous + offset, VIDEO_STRIP_BYTES) == 0)
+			continue;
+		memcpy(previous + offset, vram + offset, VIDEO_STRIP_BYTES);
+		changed |= 1u << strip;
+	}
+	return changed;
+}
+
+// Converts a run of strips
+void video_convert_strips(const uint8_t *vram, uint32_t *pixels, int pitch, int first, int count)
+{
+	if (!SDL_AtomicGet(&expand_ready))
+		build_expand();
+	for (int strip = first; strip < first + count; ++strip)
+		convert_strip(vram + strip * VIDEO_STRIP_BYTES, (uint8_t *)pixels, pitch,
+			(strip - first) * VIDEO_STRIP_COLUMNS, strip);
+}
+
+// Converts the whole screen
+void video_convert(const uint8_t *vram, uint32_t *pixels, int pitch)
+{
+	video_convert_strips(vram, pixels, pitch, 0, VIDEO_STRIPS);
+}
@@ -0,0 +1,104 @@
+/*******************************************************************************
+ * File: video.h
+ *
+ * Purpose:
+ *		Specification for turning the video memory into pixels.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "cpu.h"
+
+#include <stdint.h>
+
+/*
+ * The video memory holds the screen rotated a quarter turn: each of the 224
+ * display columns is 32 consecutive bytes, starting at the bottom of the
+ * screen with the lowest bit of each byte lowest on screen.
+ */
+#define SCREEN_WIDTH 224
+#define SCREEN_HEIGHT 256
+#define VIDEO_RAM 0x2400
+#define VIDEO_COLUMN_BYTES (SCREEN_HEIGHT / 8)
+#define VIDEO_BYTES (SCREEN_WIDTH * VIDEO_COLUMN_BYTES)
+
+/* The screen converts in strips of 8 columns. A strip is 256 bytes of video
+ * memory, exactly one page for the CPU's write tracking. */
+#define VIDEO_STRIP_COLUMNS 8
+#define VIDEO_STRIP_BYTES (VIDEO_STRIP_COLUMNS * VIDEO_COLUMN_BYTES)
+#define VIDEO_STRIPS (SCREEN_WIDTH / VIDEO_STRIP_COLUMNS)
+#define VIDEO_ALL_STRIPS ((uint32_t)((1ull << VIDEO_STRIPS) - 1))
+
+/* The monitor is mounted on its side, so the beam scans video memory in
+ * order: the first half of the strips is drawn before the mid-frame RST 1 and
+ * the second half before the vblank RST 2. */
+#define VIDEO_FIRST_HALF ((uint32_t)((1u << (VIDEO_STRIPS / 2)) - 1))
+#define VIDEO_SECOND_HALF (VIDEO_ALL_STRIPS & ~VIDEO_FIRST_HALF)
+
+#define VIDEO_BLACK 0xff000000u
+#define VIDEO_WHITE 0xffffffffu
+
+/* The colour gel strips over the cabinet's screen: the ARGB colour lit pixels
+ * take in each row, per strip of 8 pixels across. */
+typedef struct VideoOverlay {
+	uint32_t colour[SCREEN_HEIGHT][VIDEO_STRIPS];
+} VideoOverlay;
+
+/**
+ * Tints the converted screen with an overlay from now on, or goes back to
+ * plain white given NULL. Applying it is part of converting each row, so it
+ * costs next to nothing; it must not be changed while another thread is
+ * converting.
+ */
+void video_set_overlay(const VideoOverlay *overlay);
+
+/**
+ * Returns a mask with bit s set for each strip whose page of video memory was
+ * written since the epoch in *mark, then starts a new epoch there. A mark of
+ * zero reports every strip.
+ */
+uint32_t video_dirty_strips(CPUState *state, uint32_t *mark);
+
+/**
+ * Narrows a mask from video_dirty_strips() down to the strips whose bytes
+ * actually differ from previous, a VIDEO_BYTES copy of the last frame seen,
+ * and brings those strips of previous up to date. Games often rewrite a
+ * sprite with the bytes it already had, which dirties its page without
+ * changing the picture.
+ */
+uint32_t video_changed_strips(const uint8_t *vram, uint8_t *previous, uint32_t dirty);
+
+/**
+ * Converts the video memory (VIDEO_BYTES bytes starting at VIDEO_RAM) to
+ * upright ARGB8888 pixels. pitch is the number of bytes between the starts of
+ * two rows of pixels.
+ */
+void video_convert(const uint8_t *vram, uint32_t *pixels, int pitch);
+
+/**
+ * Converts strips first to first + count - 1 only. pixels points at the top
+ * left pixel of strip first, e.g. inside a texture locked to just those
+ * strips.
+ */
+void video_convert_strips(const uint8_t *vram, uint32_t *pixels, int pitch, int first, int count);
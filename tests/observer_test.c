@@ -0,0 +1,188 @@
+/*******************************************************************************
+ * File: observer_test.c
+ *
+ * Purpose:
+ *		Checks observer_downsample against a per-pixel reference and checks
+ *		frame stacking and max-pooling.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#include "observer.h"
+#include "video.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The sizes checked, including ones that don't divide the screen evenly
+static const int sizes[][2] = {
+	{ 84, 84 }, { 112, 128 }, { 224, 256 }, { 1, 1 },
+	{ 7, 13 }, { 160, 210 }, { 223, 255 }, { 56, 64 }
+};
+
+static uint32_t rng_state = 1;
+
+// xorshift32, so every run checks the same screens
+static uint32_t rng_next(void)
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+// Reads the pixel at (x, y) of the upright screen, bottom-up columns in VRAM
+static int pixel(const uint8_t *vram, int x, int y)
+{
+	int p = 255 - y;
+	return vram[x * 32 + p / 8] >> (p % 8) & 1;
+}
+
+// Averages each output box a pixel at a time, rounding as the observer does
+static void reference(const uint8_t *vram, uint8_t *out, int width, int height)
+{
+	for (int oy = 0; oy < height; oy++)
+	{
+		int y0 = oy * 256 / height, y1 = (oy + 1) * 256 / height;
+		for (int ox = 0; ox < width; ox++)
+		{
+			int x0 = ox * 224 / width, x1 = (ox + 1) * 224 / width;
+			unsigned sum = 0;
+			for (int y = y0; y < y1; y++)
+				for (int x = x0; x < x1; x++)
+					sum += pixel(vram, x, y);
+			unsigned area = (unsigned)((x1 - x0) * (y1 - y0));
+			uint32_t scale = ((255u << 16) + area / 2) / area;
+			out[oy * width + ox] = (uint8_t)((sum * scale + 0x8000) >> 16);
+		}
+	}
+}
+
+// Fills the screen empty, full, sparse or at random
+static void fill(uint8_t *vram, int kind)
+{
+	for (int i = 0; i < VIDEO_BYTES; i++)
+	{
+		uint8_t b = (uint8_t)rng_next();
+		if (kind == 0)
+			b = 0;
+		else if (kind == 1)
+			b = 0xff;
+		else if (kind == 2)
+			b &= (uint8_t)(rng_next() & rng_next());
+		vram[i] = b;
+	}
+}
+
+// Compares every size over a couple of hundred screens
+static int check_downsample(void)
+{
+	static uint8_t vram[VIDEO_BYTES], got[224 * 256], want[224 * 256];
+	int failures = 0;
+
+	for (int round = 0; round < 200; round++)
+	{
+		fill(vram, round % 5);
+		for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+		{
+			int width = sizes[s][0], height = sizes[s][1];
+			observer_downsample(vram, got, width, height);
+			reference(vram, want, width, height);
+			if (memcmp(got, want, (size_t)(width * height)) != 0)
+			{
+				fprintf(stderr, "%dx%d differs from the reference (round %d)\n",
+					width, height, round);
+				failures++;
+			}
+		}
+	}
+	return failures;
+}
+
+// Pushes two frames into a stack of four pooled observations
+static int check_stack(void)
+{
+	static uint8_t first[VIDEO_BYTES], second[VIDEO_BYTES], both[VIDEO_BYTES];
+	static uint8_t stack[4 * 84 * 84], alone[84 * 84], pooled[84 * 84];
+	const size_t plane = 84 * 84;
+	int failures = 0;
+
+	first[0] = 0xff;
+	second[100] = 0xff;
+	memcpy(both, second, sizeof(both));
+	both[0] = 0xff;
+	observer_downsample(first, alone, 84, 84);
+	observer_downsample(both, pooled, 84, 84);
+
+	Observer *observer = observer_create(84, 84, 4, 1);
+	if (!observer)
+	{
+		fprintf(stderr, "Couldn't create the observer\n");
+		return 1;
+	}
+	observer_push(observer, first);
+	observer_push(observer, second);
+	observer_read(observer, stack);
+
+	if (observer_size(observer) != sizeof(stack))
+	{
+		fprintf(stderr, "The observation is %zu bytes, expected %zu\n",
+			observer_size(observer), sizeof(stack));
+		failures++;
+	}
+	else
+	{
+		// Two black planes from before the first push, then the first screen
+		// alone and the max of both screens
+		static const uint8_t black[84 * 84];
+		if (memcmp(stack, black, plane) != 0 || memcmp(stack + plane, black, plane) != 0)
+		{
+			fprintf(stderr, "The planes from before the first push aren't black\n");
+			failures++;
+		}
+		if (memcmp(stack + 2 * plane, alone, plane) != 0)
+		{
+			fprintf(stderr, "The first plane pushed isn't the first screen\n");
+			failures++;
+		}
+		if (memcmp(stack + 3 * plane, pooled, plane) != 0)
+		{
+			fprintf(stderr, "The newest plane isn't the max of the last two screens\n");
+			failures++;
+		}
+	}
+	observer_destroy(observer);
+	return failures;
+}
+
+int main(void)
+{
+	int failures = check_downsample() + check_stack();
+	if (failures)
+	{
+		fprintf(stderr, "%d check(s) failed\n", failures);
+		return EXIT_FAILURE;
+	}
+	printf("All observer checks passed\n");
+	return EXIT_SUCCESS;
+}
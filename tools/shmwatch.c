@@ -0,0 +1,108 @@
+/*******************************************************************************
+ * File: shmwatch.c
+ *
+ * Purpose:
+ *		Watches the frames an emulator started with --shm publishes.
+ *
+ * Copyright 2026 Adam Thompson <adam@hackeradam.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#include "shmring.h"
+#include "video.h"
+
+#include <SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Writes a frame the right way up as a binary PGM image. */
+static int write_pgm(const char *path, const uint8_t *vram)
+{
+	static uint8_t image[SCREEN_HEIGHT][SCREEN_WIDTH];
+	FILE *file = fopen(path, "wb");
+	int ok;
+	if (!file)
+		return -1;
+	/* Each column is stored bottom to top, lowest bit lowest. */
+	for (int x = 0; x < SCREEN_WIDTH; ++x)
+		for (int y = 0; y < SCREEN_HEIGHT; ++y)
+			image[SCREEN_HEIGHT - 1 - y][x] =
+				(vram[x * VIDEO_COLUMN_BYTES + y / 8] >> (y % 8) & 1) ? 255 : 0;
+	ok = fprintf(file, "P5\n%d %d\n255\n", SCREEN_WIDTH, SCREEN_HEIGHT) > 0 &&
+		fwrite(image, sizeof(image), 1, file) == 1;
+	if (fclose(file) != 0)
+		ok = 0;
+	return ok ? 0 : -1;
+}
+
+/* Reads the newest frame about every millisecond for the given number of
+ * seconds, printing once a second how many frames were read whole, how many
+ * the writer published in between and how many reads were torn. */
+int main(int argc, char **argv)
+{
+	static uint8_t copy[VIDEO_BYTES];
+	ShmRing *ring;
+	int seconds = argc > 2 ? atoi(argv[2]) : 0;
+	const char *pgm_path = argc > 3 ? argv[3] : NULL;
+	uint32_t last = 0, whole = 0, skipped = 0, torn = 0;
+	int have_frame = 0;
+	uint32_t started, report;
+
+	if (argc < 2 || argv[1][0] == '-') {
+		fprintf(stderr, "usage: %s NAME [SECONDS] [FRAME.pgm]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (!(ring = shmring_attach(argv[1])))
+		return EXIT_FAILURE;
+	started = report = SDL_GetTicks();
+	while (seconds <= 0 || SDL_GetTicks() - started < (uint32_t)seconds * 1000) {
+		uint32_t frame, token;
+		const uint8_t *view = shmring_latest(ring, &frame, &token);
+		if (view && (!have_frame || frame != last)) {
+			memcpy(copy, view, VIDEO_BYTES);
+			/* A copy the writer touched meanwhile is thrown away. */
+			if (!shmring_still_valid(ring, frame, token)) {
+				torn++;
+			} else {
+				if (have_frame && frame > last + 1)
+					skipped += frame - last - 1;
+				last = frame;
+				have_frame = 1;
+				whole++;
+			}
+		}
+		if (SDL_GetTicks() - report >= 1000) {
+			printf("frame %u: %u read, %u skipped, %u torn\n", last, whole, skipped, torn);
+			fflush(stdout);
+			whole = skipped = torn = 0;
+			report = SDL_GetTicks();
+		}
+		SDL_Delay(1);
+	}
+	if (pgm_path && have_frame && write_pgm(pgm_path, copy) != 0) {
+		fprintf(stderr, "Unable to write %s\n", pgm_path);
+		shmring_destroy(ring);
+		return EXIT_FAILURE;
+	}
+	shmring_destroy(ring);
+	return EXIT_SUCCESS;
+}